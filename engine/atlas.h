@@ -1,6 +1,9 @@
 #pragma once
 
 #include "engine/math.inl"
+#include "engine/murmur_hash.inl"
+#include "engine/string_pool.h"
+#include "engine/texture.h"
 #include <collection_types.h>
 #include <glm/glm.hpp>
 
@@ -10,26 +13,70 @@ typedef Array<char> Buffer;
 
 namespace engine {
 
-struct Texture;
+namespace file {
+struct MappedFile;
+} // namespace file
 
+// A sprite in an atlas, with its texture coords computed once when the atlas loads.
 struct AtlasFrame {
     glm::vec2 pivot;
-    math::Rect rect;
+    math::Rect rect;               // In the texture, with the size of the sprite before any rotation.
+    glm::vec2 uv_min;              // The normalized region of the texture the sprite covers, top left.
+    glm::vec2 uv_max;              // Bottom right.
+    uint16_t texture_coords[4][2]; // Normalized 16 bit texture coords of the corners of the sprite's quad, rotation included.
+    math::Rect source_rect;        // Where the trimmed sprite sits in its source image.
+    glm::ivec2 source_size;        // The size of the source image before trimming.
+    bool rotated;                  // Stored rotated 90 degrees clockwise in the texture, as TexturePacker does.
+    bool trimmed;
 };
 
+// An atlas loaded from TexturePacker JSON, or from a binary atlas baked with bake_atlas which is mapped and used in place,
+// or filled in at runtime with add_atlas_frame, see AtlasBuilder.
 struct Atlas {
-    Atlas(foundation::Allocator &allocator, const char *atlas_filename);
+    Atlas(foundation::Allocator &allocator, const char *atlas_filename, const TextureOptions &texture_options = TextureOptions());
+
+    // An empty atlas of a texture, for frames added with add_atlas_frame. Takes ownership of the texture.
+    Atlas(foundation::Allocator &allocator, Texture *texture);
+
     ~Atlas();
 
     foundation::Allocator &allocator;
-    foundation::Array<foundation::Buffer *> *sprite_names;
-    foundation::Hash<AtlasFrame> *frames;
+    StringPool *sprite_names;                     // Not for baked atlases.
+    foundation::Hash<AtlasFrame> *frames;         // JSON atlases only, keyed by NameId.
+    foundation::Hash<AtlasFrame *> *added_frames; // Added with add_atlas_frame, one allocation each so they never move.
+    file::MappedFile *baked;              // Baked atlases only, the mapped file the baked fields point into.
+    const NameId *baked_keys;             // The ids of the frame names, sorted.
+    const AtlasFrame *baked_frames;       // In the order of baked_keys.
+    const uint32_t *baked_names;          // The offsets of the frame names in baked_strings, in the order of baked_keys.
+    const char *baked_strings;            // The string pool of the baked atlas.
+    uint32_t baked_frame_count;
     Texture *texture;
 };
 
+// Bakes a TexturePacker JSON atlas into the binary atlas format, a sorted key table, the frames and a string pool of
+// the names, which Atlas maps and uses in place without parsing or allocating per frame.
+void bake_atlas(foundation::Allocator &allocator, const char *atlas_filename, foundation::Buffer &baked);
+
+/**
+ * @brief Adds a frame to an atlas, or replaces the frame with the same name in place. The frame's texture coords are
+ * computed from its rect and the atlas texture. Not for baked atlases, and not while sprites are being queued.
+ *
+ * @param atlas The Atlas.
+ * @param sprite_name The name of the frame.
+ * @param frame The frame, with the rect it covers in the atlas texture.
+ * @return const AtlasFrame * The added frame, valid as long as the atlas.
+ */
+const AtlasFrame *add_atlas_frame(Atlas &atlas, const char *sprite_name, const AtlasFrame &frame);
+
 // Returns a pointer to the `AtlasFrame` which corresponds to the named sprite of the image in the atlas.
 const AtlasFrame *atlas_frame(const Atlas &atlas, const char *sprite_name);
 
+// Returns a pointer to the `AtlasFrame` of a sprite name's id, see hash_name. Skips hashing the name in hot code.
+const AtlasFrame *atlas_frame(const Atlas &atlas, NameId id);
+
+// Returns the name of a frame by its id, nullptr if the atlas has no frame with the id.
+const char *atlas_frame_name(const Atlas &atlas, NameId id);
+
 // Returns a pointer to a Rect which corresponds to the named sprite of the image in the atlas.
 // @deprecated Use `atlas_frame` instead.
 const math::Rect *atlas_rect(const Atlas &atlas, const char *sprite_name);
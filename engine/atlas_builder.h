@@ -0,0 +1,52 @@
+#pragma once
+
+#include "engine/skyline_packer.inl"
+#include <collection_types.h>
+#include <glm/glm.hpp>
+#include <inttypes.h>
+
+namespace engine {
+using namespace foundation;
+
+struct Atlas;
+struct Sprites;
+
+// A page of an AtlasBuilder, an atlas in the Sprites with its own packer.
+struct AtlasBuilderPage {
+    uint16_t atlas_index;
+    SkylinePacker packer;
+};
+
+// Packs images made at runtime, like procedurally generated sprites, into atlas pages of a Sprites. Each page is an
+// Atlas, so sprites of images on the same page batch into one draw call. Pages are added as the earlier ones fill up.
+struct AtlasBuilder {
+    // Pages are page_size pixels square, with padding pixels of transparency around each image.
+    AtlasBuilder(Allocator &allocator, Sprites &sprites, int32_t page_size = 2048, int32_t padding = 1);
+    ~AtlasBuilder();
+
+    Allocator &allocator;
+    Sprites &sprites;
+    int32_t page_size;
+    int32_t padding;
+    Array<AtlasBuilderPage> *pages;
+    Array<SkylineNode> *nodes; // The skylines of the pages, skyline_packer::max_nodes(page_size) each.
+};
+
+/**
+ * @brief Packs an image into the first page with room for it, adding a page if none has, uploads it with
+ * glTexSubImage2D and adds it to the page's atlas as a frame. Must be called on the GL thread while no sprites are
+ * being queued. Adding an image under a name already added to its page replaces that frame.
+ *
+ * Images packed in order of decreasing height use the pages best.
+ *
+ * @param builder The AtlasBuilder.
+ * @param sprite_name The name of the frame.
+ * @param rgba The RGBA8 pixels of the image, rows top to bottom.
+ * @param width The width of the image, at most the page size less twice the padding.
+ * @param height The height of the image, likewise.
+ * @param pivot The pivot of the frame.
+ * @return uint16_t The atlas index of the image's page in the Sprites, for add_sprite.
+ */
+uint16_t add_atlas_image(AtlasBuilder &builder, const char *sprite_name, const uint8_t *rgba, int32_t width, int32_t height, glm::vec2 pivot = {0.5f, 0.5f});
+
+} // namespace engine
@@ -0,0 +1,672 @@
+#pragma once
+
+#include "math.inl"
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+namespace engine {
+
+// A frame of a TexturePacker JSON atlas.
+struct AtlasJsonFrame {
+    const char *name = nullptr; // Not null terminated, valid during the on_frame call.
+    uint32_t name_length = 0;
+    glm::vec2 pivot = {0.5f, 0.5f};
+    math::Rect rect = {};        // In the texture, with the size of the sprite before rotation.
+    bool rotated = false;        // Stored rotated 90 degrees clockwise in the texture.
+    bool trimmed = false;        // Transparent borders were trimmed off the source image.
+    math::Rect source_rect = {}; // Where the trimmed sprite sits in the source image, all of it when not trimmed.
+    glm::ivec2 source_size = {}; // The size of the source image.
+};
+
+// The meta fields of a TexturePacker JSON atlas.
+struct AtlasJsonMeta {
+    const char *image = nullptr; // Not null terminated, valid during the on_meta call.
+    uint32_t image_length = 0;
+    glm::ivec2 size = {};        // The size of the image, {0, 0} if the atlas doesn't say.
+};
+
+namespace atlas_json {
+
+// The state of a parse, reading straight from the JSON without building a DOM.
+struct Parser {
+    const char *start = nullptr;
+    const char *cursor = nullptr;
+    const char *end = nullptr;
+    const char *error = nullptr; // The first error, nullptr while parsing succeeds.
+    char scratch[1024];          // Strings with escapes are decoded here, others point into the JSON.
+};
+
+inline bool fail(Parser &p, const char *error) {
+    if (!p.error) {
+        p.error = error;
+    }
+    return false;
+}
+
+inline void skip_whitespace(Parser &p) {
+    while (p.cursor < p.end && (*p.cursor == ' ' || *p.cursor == '\n' || *p.cursor == '\r' || *p.cursor == '\t')) {
+        ++p.cursor;
+    }
+}
+
+// Consumes a character if it's next after whitespace.
+inline bool consume(Parser &p, char c) {
+    skip_whitespace(p);
+    if (p.cursor < p.end && *p.cursor == c) {
+        ++p.cursor;
+        return true;
+    }
+    return false;
+}
+
+inline bool expect(Parser &p, char c, const char *error) {
+    return consume(p, c) || fail(p, error);
+}
+
+template <uint32_t N>
+bool equals(const char *string, uint32_t length, const char (&literal)[N]) {
+    return length == N - 1 && memcmp(string, literal, N - 1) == 0;
+}
+
+// Skips a string, leaving its raw contents between the quotes in string and length.
+inline bool skip_string(Parser &p, const char *&string, uint32_t &length) {
+    if (!consume(p, '"')) {
+        return fail(p, "expected a string");
+    }
+
+    string = p.cursor;
+    while (p.cursor < p.end && *p.cursor != '"') {
+        p.cursor += *p.cursor == '\\' ? 2 : 1;
+    }
+
+    if (p.cursor >= p.end) {
+        return fail(p, "unterminated string");
+    }
+
+    length = (uint32_t)(p.cursor - string);
+    ++p.cursor;
+    return true;
+}
+
+inline bool parse_hex4(Parser &p, uint32_t &code_point) {
+    if (p.end - p.cursor < 4) {
+        return fail(p, "unterminated string");
+    }
+
+    code_point = 0;
+    for (int i = 0; i < 4; ++i) {
+        const char c = *p.cursor++;
+        code_point <<= 4;
+        if (c >= '0' && c <= '9') {
+            code_point |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            code_point |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            code_point |= c - 'A' + 10;
+        } else {
+            return fail(p, "invalid \\u escape");
+        }
+    }
+
+    return true;
+}
+
+// Parses a string. Strings without escapes point into the JSON, others are decoded into the scratch buffer.
+inline bool parse_string(Parser &p, const char *&string, uint32_t &length) {
+    if (!consume(p, '"')) {
+        return fail(p, "expected a string");
+    }
+
+    const char *begin = p.cursor;
+    while (p.cursor < p.end && *p.cursor != '"' && *p.cursor != '\\') {
+        ++p.cursor;
+    }
+
+    if (p.cursor >= p.end) {
+        return fail(p, "unterminated string");
+    }
+
+    if (*p.cursor == '"') {
+        string = begin;
+        length = (uint32_t)(p.cursor - begin);
+        ++p.cursor;
+        return true;
+    }
+
+    uint32_t size = (uint32_t)(p.cursor - begin);
+    if (size >= sizeof(p.scratch)) {
+        return fail(p, "string too long");
+    }
+    memcpy(p.scratch, begin, size);
+
+    while (p.cursor < p.end && *p.cursor != '"') {
+        // Room for the longest UTF-8 sequence an escape decodes to.
+        if (size + 4 >= sizeof(p.scratch)) {
+            return fail(p, "string too long");
+        }
+
+        const char c = *p.cursor++;
+        if (c != '\\') {
+            p.scratch[size++] = c;
+            continue;
+        }
+
+        if (p.cursor >= p.end) {
+            break;
+        }
+
+        const char escape = *p.cursor++;
+        switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+            p.scratch[size++] = escape;
+            break;
+        case 'b':
+            p.scratch[size++] = '\b';
+            break;
+        case 'f':
+            p.scratch[size++] = '\f';
+            break;
+        case 'n':
+            p.scratch[size++] = '\n';
+            break;
+        case 'r':
+            p.scratch[size++] = '\r';
+            break;
+        case 't':
+            p.scratch[size++] = '\t';
+            break;
+        case 'u': {
+            uint32_t code_point = 0;
+            if (!parse_hex4(p, code_point)) {
+                return false;
+            }
+
+            // A surrogate pair.
+            if (code_point >= 0xd800 && code_point <= 0xdbff) {
+                uint32_t low = 0;
+                if (p.end - p.cursor < 2 || p.cursor[0] != '\\' || p.cursor[1] != 'u') {
+                    return fail(p, "invalid \\u escape");
+                }
+                p.cursor += 2;
+                if (!parse_hex4(p, low)) {
+                    return false;
+                }
+                if (low < 0xdc00 || low > 0xdfff) {
+                    return fail(p, "invalid \\u escape");
+                }
+                code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+            }
+
+            if (code_point < 0x80) {
+                p.scratch[size++] = (char)code_point;
+            } else if (code_point < 0x800) {
+                p.scratch[size++] = (char)(0xc0 | (code_point >> 6));
+                p.scratch[size++] = (char)(0x80 | (code_point & 0x3f));
+            } else if (code_point < 0x10000) {
+                p.scratch[size++] = (char)(0xe0 | (code_point >> 12));
+                p.scratch[size++] = (char)(0x80 | ((code_point >> 6) & 0x3f));
+                p.scratch[size++] = (char)(0x80 | (code_point & 0x3f));
+            } else {
+                p.scratch[size++] = (char)(0xf0 | (code_point >> 18));
+                p.scratch[size++] = (char)(0x80 | ((code_point >> 12) & 0x3f));
+                p.scratch[size++] = (char)(0x80 | ((code_point >> 6) & 0x3f));
+                p.scratch[size++] = (char)(0x80 | (code_point & 0x3f));
+            }
+            break;
+        }
+        default:
+            return fail(p, "invalid escape");
+        }
+    }
+
+    if (p.cursor >= p.end) {
+        return fail(p, "unterminated string");
+    }
+
+    ++p.cursor;
+    string = p.scratch;
+    length = size;
+    return true;
+}
+
+// Parses a number. Up to 19 significant digits are kept, scaled by an exact power of ten where possible.
+inline bool parse_number(Parser &p, double &value) {
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    skip_whitespace(p);
+
+    const bool negative = p.cursor < p.end && *p.cursor == '-';
+    if (negative) {
+        ++p.cursor;
+    }
+
+    if (p.cursor >= p.end || *p.cursor < '0' || *p.cursor > '9') {
+        return fail(p, "expected a number");
+    }
+
+    uint64_t mantissa = 0;
+    int32_t exponent = 0;
+
+    while (p.cursor < p.end && *p.cursor >= '0' && *p.cursor <= '9') {
+        if (mantissa < 1000000000000000000ULL) {
+            mantissa = mantissa * 10 + (*p.cursor - '0');
+        } else {
+            ++exponent;
+        }
+        ++p.cursor;
+    }
+
+    if (p.cursor < p.end && *p.cursor == '.') {
+        ++p.cursor;
+        while (p.cursor < p.end && *p.cursor >= '0' && *p.cursor <= '9') {
+            if (mantissa < 1000000000000000000ULL) {
+                mantissa = mantissa * 10 + (*p.cursor - '0');
+                --exponent;
+            }
+            ++p.cursor;
+        }
+    }
+
+    if (p.cursor < p.end && (*p.cursor == 'e' || *p.cursor == 'E')) {
+        ++p.cursor;
+
+        const bool negative_exponent = p.cursor < p.end && *p.cursor == '-';
+        if (p.cursor < p.end && (*p.cursor == '-' || *p.cursor == '+')) {
+            ++p.cursor;
+        }
+
+        if (p.cursor >= p.end || *p.cursor < '0' || *p.cursor > '9') {
+            return fail(p, "expected a number");
+        }
+
+        int32_t e = 0;
+        while (p.cursor < p.end && *p.cursor >= '0' && *p.cursor <= '9') {
+            if (e < 10000) {
+                e = e * 10 + (*p.cursor - '0');
+            }
+            ++p.cursor;
+        }
+        exponent += negative_exponent ? -e : e;
+    }
+
+    value = (double)mantissa;
+    if (exponent > 0) {
+        value = exponent <= 22 ? value * powers_of_ten[exponent] : value * pow(10.0, exponent);
+    } else if (exponent < 0) {
+        value = exponent >= -22 ? value / powers_of_ten[-exponent] : value * pow(10.0, exponent);
+    }
+
+    if (negative) {
+        value = -value;
+    }
+
+    return true;
+}
+
+inline bool skip_literal(Parser &p, const char *literal, uint32_t length) {
+    if ((uint32_t)(p.end - p.cursor) < length || memcmp(p.cursor, literal, length) != 0) {
+        return fail(p, "unexpected character");
+    }
+    p.cursor += length;
+    return true;
+}
+
+// Skips any value, like the fields of the schema that aren't read.
+inline bool skip_value(Parser &p) {
+    skip_whitespace(p);
+    if (p.cursor >= p.end) {
+        return fail(p, "unexpected end");
+    }
+
+    const char *string = nullptr;
+    uint32_t length = 0;
+    double number = 0.0;
+
+    switch (*p.cursor) {
+    case '"':
+        return skip_string(p, string, length);
+    case '{':
+    case '[': {
+        // Objects and arrays are skipped by matching brackets, without validating what's inside.
+        uint32_t depth = 0;
+        while (p.cursor < p.end) {
+            const char c = *p.cursor;
+            if (c == '"') {
+                if (!skip_string(p, string, length)) {
+                    return false;
+                }
+                continue;
+            }
+
+            ++p.cursor;
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                return true;
+            }
+        }
+        return fail(p, "unexpected end");
+    }
+    case 't':
+        return skip_literal(p, "true", 4);
+    case 'f':
+        return skip_literal(p, "false", 5);
+    case 'n':
+        return skip_literal(p, "null", 4);
+    default:
+        return parse_number(p, number);
+    }
+}
+
+/**
+ * @brief Calls on_field(key, key_length) for each field of an object, which must parse or skip the value.
+ * Keys are passed raw, keys with escapes never match the schema's.
+ */
+template <typename OnField>
+bool parse_object(Parser &p, const char *error, OnField on_field) {
+    if (!expect(p, '{', error)) {
+        return false;
+    }
+
+    if (consume(p, '}')) {
+        return true;
+    }
+
+    do {
+        const char *key = nullptr;
+        uint32_t key_length = 0;
+        if (!skip_string(p, key, key_length) || !expect(p, ':', "expected ':'") || !on_field(key, key_length)) {
+            return false;
+        }
+    } while (consume(p, ','));
+
+    return expect(p, '}', "expected '}'");
+}
+
+inline bool parse_int(Parser &p, int &value) {
+    double number = 0.0;
+    if (!parse_number(p, number)) {
+        return false;
+    }
+    value = (int)number;
+    return true;
+}
+
+inline bool parse_bool(Parser &p, bool &value) {
+    skip_whitespace(p);
+    value = p.cursor < p.end && *p.cursor == 't';
+    return value ? skip_literal(p, "true", 4) : skip_literal(p, "false", 5);
+}
+
+enum RectFields : uint32_t {
+    RectX = 1,
+    RectY = 2,
+    RectW = 4,
+    RectH = 8,
+};
+
+// Parses an object of the fields x, y, w and h, and sets the RectFields found in fields. Other fields are skipped.
+inline bool parse_rect(Parser &p, const char *error, math::Rect &rect, uint32_t &fields) {
+    fields = 0;
+    return parse_object(p, error, [&](const char *key, uint32_t key_length) {
+        if (equals(key, key_length, "x")) {
+            fields |= RectX;
+            return parse_int(p, rect.origin.x);
+        } else if (equals(key, key_length, "y")) {
+            fields |= RectY;
+            return parse_int(p, rect.origin.y);
+        } else if (equals(key, key_length, "w")) {
+            fields |= RectW;
+            return parse_int(p, rect.size.x);
+        } else if (equals(key, key_length, "h")) {
+            fields |= RectH;
+            return parse_int(p, rect.size.y);
+        }
+        return skip_value(p);
+    });
+}
+
+// Parses the fields of a frame object into frame, except the name when it's the key of a hash of frames.
+inline bool parse_frame(Parser &p, AtlasJsonFrame &frame, bool named) {
+    bool has_rect = false;
+    uint32_t rect_fields = 0;
+    uint32_t source_rect_fields = 0;
+    uint32_t source_size_fields = 0;
+
+    const bool parsed = parse_object(p, "expected a frame {...}", [&](const char *key, uint32_t key_length) {
+        if (!named && equals(key, key_length, "filename")) {
+            named = true;
+            return parse_string(p, frame.name, frame.name_length);
+        }
+
+        if (equals(key, key_length, "frame")) {
+            has_rect = true;
+            return parse_rect(p, "frame \"frame\" isn't an object", frame.rect, rect_fields);
+        }
+
+        if (equals(key, key_length, "rotated")) {
+            return parse_bool(p, frame.rotated);
+        }
+
+        if (equals(key, key_length, "trimmed")) {
+            return parse_bool(p, frame.trimmed);
+        }
+
+        if (equals(key, key_length, "spriteSourceSize")) {
+            return parse_rect(p, "frame \"spriteSourceSize\" isn't an object", frame.source_rect, source_rect_fields);
+        }
+
+        if (equals(key, key_length, "sourceSize")) {
+            math::Rect source = {};
+            const bool parsed_source = parse_rect(p, "frame \"sourceSize\" isn't an object", source, source_size_fields);
+            frame.source_size = source.size;
+            return parsed_source;
+        }
+
+        if (equals(key, key_length, "pivot")) {
+            bool has_pivot_x = false;
+            bool has_pivot_y = false;
+            const bool parsed_pivot = parse_object(p, "frame \"pivot\" isn't an object", [&](const char *pivot_key, uint32_t pivot_key_length) {
+                double value = 0.0;
+                if (equals(pivot_key, pivot_key_length, "x")) {
+                    has_pivot_x = true;
+                    const bool parsed_value = parse_number(p, value);
+                    frame.pivot.x = (float)value;
+                    return parsed_value;
+                } else if (equals(pivot_key, pivot_key_length, "y")) {
+                    has_pivot_y = true;
+                    const bool parsed_value = parse_number(p, value);
+                    frame.pivot.y = (float)value;
+                    return parsed_value;
+                }
+                return skip_value(p);
+            });
+
+            if (!parsed_pivot) {
+                return false;
+            } else if (!has_pivot_x) {
+                return fail(p, "frame pivot missing \"x\"");
+            } else if (!has_pivot_y) {
+                return fail(p, "frame pivot missing \"y\"");
+            }
+            return true;
+        }
+
+        return skip_value(p);
+    });
+
+    if (!parsed) {
+        return false;
+    } else if (!named) {
+        return fail(p, "frame missing \"filename\"");
+    } else if (!has_rect) {
+        return fail(p, "frame missing \"frame\"");
+    } else if (!(rect_fields & RectX)) {
+        return fail(p, "frame missing \"x\"");
+    } else if (!(rect_fields & RectY)) {
+        return fail(p, "frame missing \"y\"");
+    } else if (!(rect_fields & RectW)) {
+        return fail(p, "frame missing \"w\"");
+    } else if (!(rect_fields & RectH)) {
+        return fail(p, "frame missing \"h\"");
+    }
+
+    // Untrimmed sprites fill their source image.
+    if (source_rect_fields != (RectX | RectY | RectW | RectH)) {
+        frame.source_rect.origin = {0, 0};
+        frame.source_rect.size = frame.rect.size;
+    }
+
+    if (source_size_fields != (RectW | RectH)) {
+        frame.source_size = frame.source_rect.origin + frame.source_rect.size;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Parses a TexturePacker JSON atlas in one pass straight from the buffer, without building a DOM or allocating.
+ * Reads the "frames" array of the JSON-Array format or the "frames" object of the JSON-Hash format, and the "image" and
+ * "size" of "meta". Other fields are skipped.
+ *
+ * @param json The JSON, doesn't need to be null terminated.
+ * @param size The size of the JSON in bytes.
+ * @param on_meta Called with the AtlasJsonMeta.
+ * @param on_frame Called with each AtlasJsonFrame, in the order of the JSON.
+ * @param error Set to a description of the error when parsing fails.
+ * @param error_offset Set to the byte offset of the error when parsing fails.
+ * @return bool Whether the atlas parsed.
+ */
+template <typename OnMeta, typename OnFrame>
+bool parse(const char *json, uint32_t size, OnMeta on_meta, OnFrame on_frame, const char *&error, uint32_t &error_offset) {
+    Parser p;
+    p.start = json;
+    p.cursor = json;
+    p.end = json + size;
+
+    bool has_frames = false;
+    bool has_image = false;
+
+    // A UTF-8 byte order mark.
+    if (size >= 3 && memcmp(json, "\xef\xbb\xbf", 3) == 0) {
+        p.cursor += 3;
+    }
+
+    const bool parsed = parse_object(p, "expected an object", [&](const char *key, uint32_t key_length) {
+        if (equals(key, key_length, "frames")) {
+            has_frames = true;
+
+            skip_whitespace(p);
+            const bool hash = p.cursor < p.end && *p.cursor == '{';
+
+            // JSON-Hash, frames keyed by their names.
+            if (hash) {
+                ++p.cursor;
+                if (consume(p, '}')) {
+                    return true;
+                }
+
+                do {
+                    AtlasJsonFrame frame;
+                    if (!parse_string(p, frame.name, frame.name_length) || !expect(p, ':', "expected ':'") || !parse_frame(p, frame, true)) {
+                        return false;
+                    }
+
+                    on_frame(frame);
+                } while (consume(p, ','));
+
+                return expect(p, '}', "expected '}'");
+            }
+
+            // JSON-Array
+            if (!expect(p, '[', "missing \"frames\": [...]")) {
+                return false;
+            }
+
+            if (consume(p, ']')) {
+                return true;
+            }
+
+            do {
+                AtlasJsonFrame frame;
+                if (!parse_frame(p, frame, false)) {
+                    return false;
+                }
+
+                on_frame(frame);
+            } while (consume(p, ','));
+
+            return expect(p, ']', "expected ']'");
+        }
+
+        if (equals(key, key_length, "meta")) {
+            AtlasJsonMeta meta;
+            char image[sizeof(p.scratch)]; // Later strings with escapes reuse the scratch buffer.
+            const bool parsed_meta = parse_object(p, "missing \"meta\": {...}", [&](const char *meta_key, uint32_t meta_key_length) {
+                if (equals(meta_key, meta_key_length, "image")) {
+                    if (!parse_string(p, meta.image, meta.image_length)) {
+                        return false;
+                    }
+
+                    if (meta.image == p.scratch) {
+                        memcpy(image, p.scratch, meta.image_length);
+                        meta.image = image;
+                    }
+
+                    has_image = true;
+                    return true;
+                }
+
+                if (equals(meta_key, meta_key_length, "size")) {
+                    math::Rect image_rect = {};
+                    uint32_t fields = 0;
+                    const bool parsed_size = parse_rect(p, "meta \"size\" isn't an object", image_rect, fields);
+                    if (fields == (RectW | RectH)) {
+                        meta.size = image_rect.size;
+                    }
+                    return parsed_size;
+                }
+
+                return skip_value(p);
+            });
+
+            if (!parsed_meta) {
+                return false;
+            } else if (!has_image) {
+                return fail(p, "meta missing \"image\"");
+            }
+
+            on_meta(meta);
+            return true;
+        }
+
+        return skip_value(p);
+    });
+
+    if (parsed) {
+        skip_whitespace(p);
+        if (p.cursor != p.end && *p.cursor != '\0') {
+            fail(p, "unexpected data after the atlas");
+        } else if (!has_frames) {
+            fail(p, "missing \"frames\": [...]");
+        } else if (!has_image) {
+            fail(p, "meta missing \"image\"");
+        }
+    }
+
+    if (p.error) {
+        error = p.error;
+        error_offset = (uint32_t)(p.cursor - p.start);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace atlas_json
+} // namespace engine
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <inttypes.h>
 
 namespace engine {
 namespace color {
@@ -33,6 +34,25 @@ constexpr glm::vec4 peach = {255.0f / 255, 204.0f / 255, 170.0f / 255, 1.0f};
 
 } // namespace pico8
 
+// Packs a color into 8 bits per channel, laid out as R, G, B, A in memory.
+constexpr uint32_t pack_rgba8(const glm::vec4 color) {
+    auto channel = [](const float f) {
+        const float clamped = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+        return (uint32_t)(clamped * 255.0f + 0.5f);
+    };
+
+    return channel(color.r) | (channel(color.g) << 8) | (channel(color.b) << 16) | (channel(color.a) << 24);
+}
+
+// Unpacks a color packed by pack_rgba8.
+constexpr glm::vec4 unpack_rgba8(const uint32_t packed) {
+    return {
+        (packed & 0xff) / 255.0f,
+        ((packed >> 8) & 0xff) / 255.0f,
+        ((packed >> 16) & 0xff) / 255.0f,
+        ((packed >> 24) & 0xff) / 255.0f};
+}
+
 inline float luminance(const glm::vec4 color) {
     return 0.2126f * powf(color.r, 2.2f) + 0.7152f * powf(color.g, 2.2f) + 0.0722f * powf(color.b, 2.2f);
 }
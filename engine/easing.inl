@@ -0,0 +1,143 @@
+#pragma once
+
+#include <inttypes.h>
+#include <math.h>
+
+namespace engine {
+
+// The shape of the interpolation from one value to the next.
+enum class Easing : uint8_t {
+    Linear,
+    EaseIn,      // Starts slow, cubic.
+    EaseOut,     // Ends slow, cubic.
+    EaseInOut,   // Starts and ends slow, cubic.
+    Step,        // Holds the first value until the end.
+    CubicBezier, // Follows a CubicBezier, like CSS cubic-bezier().
+};
+
+// A cubic Bezier timing curve from (0, 0) to (1, 1) with the control points (x1, y1) and (x2, y2).
+// The polynomial coefficients and a table of x samples are precomputed so evaluating it only needs a few Newton steps.
+struct CubicBezier {
+    static constexpr uint32_t sample_count = 11;
+
+    float ax, bx, cx;
+    float ay, by, cy;
+    float samples[sample_count]; // x at evenly spaced parameters.
+};
+
+namespace easing {
+
+inline float sample_x(const CubicBezier &curve, float t) {
+    return ((curve.ax * t + curve.bx) * t + curve.cx) * t;
+}
+
+inline float sample_y(const CubicBezier &curve, float t) {
+    return ((curve.ay * t + curve.by) * t + curve.cy) * t;
+}
+
+inline float sample_dx(const CubicBezier &curve, float t) {
+    return (3.0f * curve.ax * t + 2.0f * curve.bx) * t + curve.cx;
+}
+
+// Returns a cubic Bezier timing curve. The x coordinates are clamped to [0, 1] so the curve is a function of x.
+inline CubicBezier cubic_bezier(float x1, float y1, float x2, float y2) {
+    x1 = fminf(fmaxf(x1, 0.0f), 1.0f);
+    x2 = fminf(fmaxf(x2, 0.0f), 1.0f);
+
+    CubicBezier curve;
+    curve.cx = 3.0f * x1;
+    curve.bx = 3.0f * (x2 - x1) - curve.cx;
+    curve.ax = 1.0f - curve.cx - curve.bx;
+    curve.cy = 3.0f * y1;
+    curve.by = 3.0f * (y2 - y1) - curve.cy;
+    curve.ay = 1.0f - curve.cy - curve.by;
+
+    for (uint32_t i = 0; i < CubicBezier::sample_count; ++i) {
+        curve.samples[i] = sample_x(curve, (float)i / (CubicBezier::sample_count - 1));
+    }
+
+    return curve;
+}
+
+// Returns the y of a cubic Bezier timing curve at x.
+inline float evaluate(const CubicBezier &curve, float x) {
+    if (x <= 0.0f) {
+        return 0.0f;
+    }
+
+    if (x >= 1.0f) {
+        return 1.0f;
+    }
+
+    constexpr float step = 1.0f / (CubicBezier::sample_count - 1);
+
+    // Start from the sample interval holding x, then refine.
+    uint32_t i = 1;
+    while (i < CubicBezier::sample_count - 1 && curve.samples[i] <= x) {
+        ++i;
+    }
+    --i;
+
+    const float interval = curve.samples[i + 1] - curve.samples[i];
+    float t = (i + (interval > 0.0f ? (x - curve.samples[i]) / interval : 0.0f)) * step;
+
+    for (int iteration = 0; iteration < 4; ++iteration) {
+        const float dx = sample_dx(curve, t);
+        if (fabsf(dx) < 1e-6f) {
+            break;
+        }
+
+        t -= (sample_x(curve, t) - x) / dx;
+    }
+
+    // Newton steps can leave the interval where the slope is flat, bisect instead.
+    float low = i * step;
+    float high = (i + 1) * step;
+    if (t < low || t > high) {
+        t = (low + high) * 0.5f;
+        for (int iteration = 0; iteration < 16; ++iteration) {
+            if (sample_x(curve, t) < x) {
+                low = t;
+            } else {
+                high = t;
+            }
+
+            t = (low + high) * 0.5f;
+        }
+    }
+
+    return sample_y(curve, t);
+}
+
+} // namespace easing
+
+// Returns how far to interpolate at a, from 0 to 1, with an easing. The curve is only used with Easing::CubicBezier,
+// without one it eases linearly.
+inline float ease(Easing easing, float a, const CubicBezier *curve = nullptr) {
+    switch (easing) {
+    case Easing::Linear:
+        return a;
+    case Easing::EaseIn:
+        return a * a * a;
+    case Easing::EaseOut: {
+        const float b = 1.0f - a;
+        return 1.0f - b * b * b;
+    }
+    case Easing::EaseInOut: {
+        if (a < 0.5f) {
+            return 4.0f * a * a * a;
+        }
+
+        const float b = -2.0f * a + 2.0f;
+        return 1.0f - b * b * b * 0.5f;
+    }
+    case Easing::Step:
+        return a < 1.0f ? 0.0f : 1.0f;
+    case Easing::CubicBezier:
+        return curve ? easing::evaluate(*curve, a) : a;
+    }
+
+    return a;
+}
+
+} // namespace engine
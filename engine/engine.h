@@ -12,6 +12,8 @@ struct Engine;
 struct Input;
 struct InputCommand;
 struct Shader;
+struct TextureLoader;
+struct ThreadPool;
 
 struct EngineCallbacks {
     void (*on_input)(Engine &engine, void *game_object, InputCommand &input_command) = nullptr;
@@ -19,6 +21,10 @@ struct EngineCallbacks {
     void (*render)(Engine &engine, void *game_object) = nullptr;
     void (*render_imgui)(Engine &engine, void *game_object) = nullptr;
 
+    // Called once per frame on the main thread with neither update nor render running, after the update.
+    // The point to publish the state the update produced to the renderer, e.g. with swap_sprites.
+    void (*swap)(Engine &engine, void *game_object) = nullptr;
+
     // Return false to clear the should close flag.
     bool (*on_shutdown)(Engine &engine, void *game_object) = nullptr;
 };
@@ -42,6 +48,15 @@ struct Engine {
 
     Input *input;
 
+    // Worker threads shared by engine systems, sized by [engine] worker_threads.
+    ThreadPool *thread_pool;
+
+    // Decodes textures on the worker threads and uploads them between frames, see load_texture.
+    TextureLoader *texture_loader;
+
+    // The time in seconds each frame may spend uploading textures, set in milliseconds by [engine] texture_upload_ms.
+    double texture_upload_budget;
+
     float camera_zoom;
     int32_t render_scale;
     glm::ivec2 camera_offset;
@@ -49,6 +64,12 @@ struct Engine {
     bool terminating;
     bool wait_vsync;
     uint32_t fps_limit;
+
+    // Runs update on a thread of its own while render draws the previous frame, set by [engine] parallel_update.
+    // Render callbacks must then only read state published in the swap callback. The update thread has no GL
+    // context, so whatever creates GL objects, like constructing Sprites or add_sprites_atlas with a filename,
+    // belongs in on_input or the swap callback.
+    bool parallel_update;
 };
 
 // Runs the engine, returns the exit code.
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cassert>
+#include <inttypes.h>
+
+namespace engine {
+
+// The fence operations used by a FenceRing. Replaceable with mocks in tests.
+struct FenceOps {
+    // Inserts a fence after all commands issued so far and returns it.
+    void *(*insert)(void *user_data) = nullptr;
+
+    // Blocks until the fence is signaled.
+    void (*wait)(void *user_data, void *fence) = nullptr;
+
+    // Deletes the fence.
+    void (*remove)(void *user_data, void *fence) = nullptr;
+
+    void *user_data = nullptr;
+};
+
+// A ring of buffer regions, each guarded by its own fence. The CPU writes into one region while the GPU may
+// still be reading the others, and only waits when it wraps around to a region the GPU hasn't finished with.
+struct FenceRing {
+    static constexpr uint32_t max_regions = 4;
+
+    FenceOps ops;
+    uint32_t region_count = 3;
+    uint32_t current = 0; // The region last acquired for writing.
+    void *fences[max_regions] = {};
+};
+
+namespace fence_ring {
+
+// Advances to the next region, waits until the GPU is done reading it and returns its index.
+inline uint32_t acquire(FenceRing &ring) {
+    assert(ring.region_count > 0 && ring.region_count <= FenceRing::max_regions);
+
+    ring.current = (ring.current + 1) % ring.region_count;
+
+    void *fence = ring.fences[ring.current];
+    if (fence) {
+        ring.ops.wait(ring.ops.user_data, fence);
+        ring.ops.remove(ring.ops.user_data, fence);
+        ring.fences[ring.current] = nullptr;
+    }
+
+    return ring.current;
+}
+
+// Fences a region after the commands reading from it have been issued.
+inline void fence(FenceRing &ring, uint32_t region) {
+    assert(region < ring.region_count);
+
+    if (ring.fences[region]) {
+        ring.ops.remove(ring.ops.user_data, ring.fences[region]);
+    }
+
+    ring.fences[region] = ring.ops.insert(ring.ops.user_data);
+}
+
+// Waits for and deletes every pending fence, e.g. before the buffer backing the ring is replaced.
+inline void clear(FenceRing &ring) {
+    for (uint32_t i = 0; i < FenceRing::max_regions; ++i) {
+        if (ring.fences[i]) {
+            ring.ops.wait(ring.ops.user_data, ring.fences[i]);
+            ring.ops.remove(ring.ops.user_data, ring.fences[i]);
+            ring.fences[i] = nullptr;
+        }
+    }
+}
+
+} // namespace fence_ring
+} // namespace engine
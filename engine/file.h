@@ -1,5 +1,7 @@
 #pragma once
 
+#include <inttypes.h>
+
 namespace foundation {
 template <typename T> struct Array;
 }
@@ -11,5 +13,30 @@ bool exist(const char *filename);
 bool write(foundation::Array<char> &buffer, const char *filename);
 bool read(foundation::Array<char> &buffer, const char *filename);
 
+// The size and last modification time of a file.
+struct FileInfo {
+    uint64_t size = 0;
+    uint64_t modified = 0; // In platform specific units, only for comparing with other times from info.
+};
+
+// Gets the size and last modification time of a file.
+bool info(FileInfo &info, const char *filename);
+
+// Writes data to a file, replacing it if it exists. The data goes to a temporary file which is renamed over filename,
+// so readers see either the old file or the whole new one.
+bool replace(const char *filename, const void *data, uint64_t size);
+
+// A read-only view of a whole file mapped into memory.
+struct MappedFile {
+    const char *data = nullptr;
+    uint64_t size = 0;
+};
+
+// Maps a file into memory read-only, so it can be used in place without reading it into a buffer.
+bool map(MappedFile &mapped, const char *filename);
+
+// Unmaps a file mapped with map.
+void unmap(MappedFile &mapped);
+
 } // namespace file
 } // namespace engine
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "easing.inl"
+#include <cassert>
+#include <inttypes.h>
+
+namespace engine {
+
+// A value at a time in a keyframe track. The easing shapes the interpolation from this key to the next.
+template <typename T>
+struct Keyframe {
+    float time = 0.0f;
+    T value = {};
+    Easing easing = Easing::Linear;
+    const CubicBezier *curve = nullptr; // Used with Easing::CubicBezier, not owned.
+};
+
+namespace keyframes {
+
+/**
+ * @brief Returns the segment, the index of the key starting it, that holds a time.
+ * Checks the cursor's segment and the one after it first, so tracks played forward don't search at all.
+ * Otherwise binary searches and moves the cursor.
+ *
+ * @param keys The keys, sorted by time.
+ * @param count The number of keys, at least 2.
+ * @param time The time, between the first and last key.
+ * @param cursor The segment found last time. Updated to the segment found.
+ * @return uint32_t The segment holding time.
+ */
+template <typename T>
+uint32_t find_segment(const Keyframe<T> *keys, uint32_t count, float time, uint32_t &cursor) {
+    assert(count >= 2);
+
+    const uint32_t last_segment = count - 2;
+
+    for (uint32_t segment = cursor; segment <= cursor + 1 && segment <= last_segment; ++segment) {
+        if (keys[segment].time <= time && (time < keys[segment + 1].time || segment == last_segment)) {
+            cursor = segment;
+            return segment;
+        }
+    }
+
+    // The first key after time.
+    uint32_t low = 0;
+    uint32_t high = count;
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2;
+        if (keys[middle].time <= time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    cursor = low == 0 ? 0 : (low - 1 > last_segment ? last_segment : low - 1);
+    return cursor;
+}
+
+// Returns the value of a track at a time, holding the first and last values outside the track. See find_segment.
+template <typename T>
+T evaluate(const Keyframe<T> *keys, uint32_t count, float time, uint32_t &cursor) {
+    assert(count > 0);
+
+    if (count == 1 || time <= keys[0].time) {
+        return keys[0].value;
+    }
+
+    if (time >= keys[count - 1].time) {
+        cursor = count - 2;
+        return keys[count - 1].value;
+    }
+
+    const uint32_t segment = find_segment(keys, count, time, cursor);
+    const Keyframe<T> &from = keys[segment];
+    const Keyframe<T> &to = keys[segment + 1];
+
+    const float duration = to.time - from.time;
+    const float a = duration > 0.0f ? (time - from.time) / duration : 1.0f;
+    return from.value + (to.value - from.value) * ease(from.easing, a, from.curve);
+}
+
+// Returns the time of the last key, the duration of a track.
+template <typename T>
+float duration(const Keyframe<T> *keys, uint32_t count) {
+    return count > 0 ? keys[count - 1].time : 0.0f;
+}
+
+} // namespace keyframes
+} // namespace engine
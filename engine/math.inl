@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <glm/glm.hpp>
+#include <inttypes.h>
 
 namespace math {
 
@@ -11,6 +12,55 @@ struct Vertex {
     glm::vec2 texture_coords;
 };
 
+// A compact vertex with 16 bit normalized texture coordinates and an 8 bit per channel RGBA color.
+struct PackedVertex {
+    glm::vec3 position;
+    uint16_t texture_coords[2];
+    uint32_t color;
+};
+
+// A 2D affine transform with a depth. The x and y axes and the origin are the columns of a 2x3 matrix.
+struct Transform2D {
+    glm::vec2 x_axis = {1.0f, 0.0f};
+    glm::vec2 y_axis = {0.0f, 1.0f};
+    glm::vec2 origin = {0.0f, 0.0f};
+    float z = 0.0f;
+};
+
+// Returns the transform applying b, then a.
+inline Transform2D operator*(const Transform2D &a, const Transform2D &b) {
+    Transform2D t;
+    t.x_axis = a.x_axis * b.x_axis.x + a.y_axis * b.x_axis.y;
+    t.y_axis = a.x_axis * b.y_axis.x + a.y_axis * b.y_axis.y;
+    t.origin = a.origin + a.x_axis * b.origin.x + a.y_axis * b.origin.y;
+    t.z = a.z + b.z;
+    return t;
+}
+
+// Transforms a point.
+inline glm::vec2 transform_point(const Transform2D &t, const glm::vec2 point) {
+    return t.origin + t.x_axis * point.x + t.y_axis * point.y;
+}
+
+// Converts a 3D transform to a 2D transform, keeping its xy part and z translation.
+inline Transform2D to_transform2d(const glm::mat4 &m) {
+    Transform2D t;
+    t.x_axis = {m[0].x, m[0].y};
+    t.y_axis = {m[1].x, m[1].y};
+    t.origin = {m[3].x, m[3].y};
+    t.z = m[3].z;
+    return t;
+}
+
+// Converts a 2D transform to a 3D transform.
+inline glm::mat4 to_mat4(const Transform2D &t) {
+    glm::mat4 m(1.0f);
+    m[0] = {t.x_axis, 0.0f, 0.0f};
+    m[1] = {t.y_axis, 0.0f, 0.0f};
+    m[3] = {t.origin, t.z, 1.0f};
+    return m;
+}
+
 struct Rect {
     glm::ivec2 origin;
     glm::ivec2 size;
@@ -78,6 +128,14 @@ constexpr int32_t index_offset(int32_t const idx, int32_t const xoffset, int32_t
     return index(x + xoffset, y + yoffset, max_width);
 }
 
+/**
+ * @brief Packs a float in the range [0, 1] into a normalized unsigned 16 bit integer.
+ */
+constexpr uint16_t pack_unorm16(const float f) {
+    const float clamped = f < 0.0f ? 0.0f : (f > 1.0f ? 1.0f : f);
+    return (uint16_t)(clamped * 65535.0f + 0.5f);
+}
+
 /**
  * @brief Linear interpolation.
  */
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace engine {
+namespace mipmap {
+
+// Returns the size of a side of a mip level, halved per level and rounded down like GL does, at least 1.
+constexpr int32_t level_size(int32_t size, uint32_t level) {
+    return (size >> level) > 0 ? (size >> level) : 1;
+}
+
+/**
+ * @brief Returns the highest mip level worth generating for a texture.
+ *
+ * @param width The width of level 0.
+ * @param height The height of level 0.
+ * @param atlas_padding The transparent pixels between the frames of an atlas, or -1 when the texture isn't an atlas.
+ * A level's texels span 2^level pixels, so levels stop once that's wider than the padding, before frames blend into
+ * their neighbors.
+ * @return uint32_t The highest level, 0 for no mipmaps.
+ */
+inline uint32_t max_level(int32_t width, int32_t height, int32_t atlas_padding) {
+    uint32_t level = 0;
+    while (level_size(width, level) > 1 || level_size(height, level) > 1) {
+        if (atlas_padding >= 0 && (1 << (level + 1)) > atlas_padding) {
+            break;
+        }
+
+        ++level;
+    }
+
+    return level;
+}
+
+/**
+ * @brief Box filters RGBA8 pixels down to the next mip level, each texel the rounded average of 2x2 pixels. An odd last
+ * row or column is dropped, like GL sizes levels, except when it's the only one.
+ *
+ * @param source The RGBA8 pixels of the level, rows top to bottom.
+ * @param width The width of the level.
+ * @param height The height of the level.
+ * @param destination Room for level_size(width, 1) * level_size(height, 1) pixels.
+ */
+inline void downsample(const uint8_t *source, int32_t width, int32_t height, uint8_t *destination) {
+    const int32_t destination_width = level_size(width, 1);
+    const int32_t destination_height = level_size(height, 1);
+
+    for (int32_t y = 0; y < destination_height; ++y) {
+        const uint8_t *row0 = source + (size_t)(y * 2) * width * 4;
+        const uint8_t *row1 = source + (size_t)(y * 2 + 1 < height ? y * 2 + 1 : height - 1) * width * 4;
+        uint8_t *out = destination + (size_t)y * destination_width * 4;
+        int32_t x = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+        // 8 pixels of both rows to 4 texels, summed in 16 bits per channel.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+
+        for (; x + 4 <= destination_width; x += 4) {
+            const __m128i a0 = _mm_loadu_si128((const __m128i *)(row0 + x * 8));
+            const __m128i a1 = _mm_loadu_si128((const __m128i *)(row0 + x * 8 + 16));
+            const __m128i b0 = _mm_loadu_si128((const __m128i *)(row1 + x * 8));
+            const __m128i b1 = _mm_loadu_si128((const __m128i *)(row1 + x * 8 + 16));
+
+            // Columns summed down both rows, two pixels per register.
+            const __m128i columns01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+            const __m128i columns23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+            const __m128i columns45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+            const __m128i columns67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+            // Neighboring columns summed, then rounded and divided by four.
+            const __m128i texels01 = _mm_add_epi16(_mm_unpacklo_epi64(columns01, columns23), _mm_unpackhi_epi64(columns01, columns23));
+            const __m128i texels23 = _mm_add_epi16(_mm_unpacklo_epi64(columns45, columns67), _mm_unpackhi_epi64(columns45, columns67));
+
+            const __m128i rounded01 = _mm_srli_epi16(_mm_add_epi16(texels01, two), 2);
+            const __m128i rounded23 = _mm_srli_epi16(_mm_add_epi16(texels23, two), 2);
+            _mm_storeu_si128((__m128i *)(out + x * 4), _mm_packus_epi16(rounded01, rounded23));
+        }
+#endif
+
+        for (; x < destination_width; ++x) {
+            const int32_t x0 = x * 2;
+            const int32_t x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+
+            for (int32_t channel = 0; channel < 4; ++channel) {
+                const uint32_t sum = row0[x0 * 4 + channel] + row0[x1 * 4 + channel] + row1[x0 * 4 + channel] + row1[x1 * 4 + channel];
+                out[x * 4 + channel] = (uint8_t)((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+} // namespace mipmap
+} // namespace engine
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <inttypes.h>
+#include <thread>
+
+namespace engine {
+
+// A bounded lock-free queue for many producer threads and a single consumer, after Dmitry Vyukov's bounded queue.
+// Each cell carries a sequence number telling producers and the consumer whose turn it is, so producers only
+// contend on claiming a slot and never wait on each other's writes.
+template <typename T, uint32_t Capacity>
+struct MPSCQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MPSCQueue capacity must be a power of two");
+
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        T data;
+    };
+
+    MPSCQueue() {
+        for (uint32_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    alignas(64) std::atomic<uint32_t> tail = {0}; // The next slot producers claim.
+    alignas(64) uint32_t head = 0;                // The next slot the consumer reads.
+    alignas(64) Cell cells[Capacity];
+};
+
+namespace mpsc_queue {
+
+// Pushes a value unless the queue is full. Safe to call from any number of threads.
+template <typename T, uint32_t Capacity>
+bool try_push(MPSCQueue<T, Capacity> &queue, const T &value) {
+    uint32_t position = queue.tail.load(std::memory_order_relaxed);
+    typename MPSCQueue<T, Capacity>::Cell *cell = nullptr;
+
+    for (;;) {
+        cell = &queue.cells[position & (Capacity - 1)];
+        const uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const int32_t difference = (int32_t)(sequence - position);
+
+        if (difference == 0) {
+            if (queue.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The consumer hasn't read this cell since the last lap.
+            return false;
+        } else {
+            position = queue.tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->data = value;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+// Pops the oldest value into `value` unless the queue is empty. Only one thread may pop at a time.
+template <typename T, uint32_t Capacity>
+bool try_pop(MPSCQueue<T, Capacity> &queue, T &value) {
+    typename MPSCQueue<T, Capacity>::Cell *cell = &queue.cells[queue.head & (Capacity - 1)];
+    const uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+    // The producer claiming this cell hasn't finished writing it, or nothing has been pushed.
+    if ((int32_t)(sequence - (queue.head + 1)) < 0) {
+        return false;
+    }
+
+    value = cell->data;
+    cell->sequence.store(queue.head + Capacity, std::memory_order_release);
+    ++queue.head;
+    return true;
+}
+
+// Pushes a value, yielding until the consumer makes room if the queue is full.
+template <typename T, uint32_t Capacity>
+void push(MPSCQueue<T, Capacity> &queue, const T &value) {
+    while (!try_push(queue, value)) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace mpsc_queue
+} // namespace engine
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <inttypes.h>
+
+namespace engine {
+namespace murmur_hash {
+
+// A constexpr MurmurHash64A, giving the same keys as foundation's murmur_hash_64 on little endian platforms.
+constexpr uint64_t hash_64(const char *key, uint32_t len, uint64_t seed) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+
+    uint64_t h = seed ^ (len * m);
+
+    const uint32_t blocks = len / 8;
+    for (uint32_t block = 0; block < blocks; ++block) {
+        uint64_t k = 0;
+        for (int byte = 7; byte >= 0; --byte) {
+            k = (k << 8) | (uint8_t)key[block * 8 + byte];
+        }
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    const uint32_t tail = len & 7;
+    if (tail > 0) {
+        for (int byte = (int)tail - 1; byte >= 0; --byte) {
+            h ^= (uint64_t)(uint8_t)key[blocks * 8 + byte] << (byte * 8);
+        }
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return h;
+}
+
+constexpr uint32_t length(const char *s) {
+    uint32_t len = 0;
+    while (s[len]) {
+        ++len;
+    }
+    return len;
+}
+
+} // namespace murmur_hash
+
+// The id of a name, like an atlas frame name, which is the name's murmur hash. See StringPool.
+typedef uint64_t NameId;
+
+// Returns the id of a name. Hash names known ahead of time at compile time:
+// constexpr NameId idle = engine::hash_name("player_idle");
+constexpr NameId hash_name(const char *name) {
+    return murmur_hash::hash_64(name, murmur_hash::length(name), 0);
+}
+
+} // namespace engine
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Builds with AVX2 or SSSE3 enabled, see CHOCOLATE_AVX2, use their shuffles. Otherwise x64 builds use SSE2 where it
+// helps and fall back to scalar loops elsewhere.
+namespace engine {
+namespace pixels {
+
+/**
+ * @brief Expands RGB8 pixels to RGBA8 with opaque alpha.
+ *
+ * @param rgb count pixels of 3 bytes.
+ * @param rgba Room for count pixels of 4 bytes, not overlapping rgb.
+ * @param count The number of pixels.
+ */
+inline void rgb_to_rgba(const uint8_t *rgb, uint8_t *rgba, size_t count) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    // Spreads 24 bytes over both lanes, 12 bytes each, then shuffles a fourth byte into each pixel. The load reads
+    // 32 bytes, so stop while 11 pixels remain.
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+    const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+
+    for (; i + 11 <= count; i += 8) {
+        const __m256i source = _mm256_loadu_si256((const __m256i *)(rgb + i * 3));
+        const __m256i spread = _mm256_permutevar8x32_epi32(source, lanes);
+        _mm256_storeu_si256((__m256i *)(rgba + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(spread, shuffle), alpha));
+    }
+#elif defined(__SSSE3__)
+    // 16 pixels from three loads, realigned so each shuffle sees four whole pixels.
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+    for (; i + 16 <= count; i += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(rgb + i * 3));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(rgb + i * 3 + 16));
+        const __m128i c = _mm_loadu_si128((const __m128i *)(rgb + i * 3 + 32));
+
+        __m128i *out = (__m128i *)(rgba + i * 4);
+        _mm_storeu_si128(out + 0, _mm_or_si128(_mm_shuffle_epi8(a, shuffle), alpha));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle), alpha));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle), alpha));
+        _mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle), alpha));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        rgba[i * 4 + 0] = rgb[i * 3 + 0];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+/**
+ * @brief Expands gray pixels to RGBA8 with opaque alpha.
+ *
+ * @param gray count pixels of 1 byte.
+ * @param rgba Room for count pixels of 4 bytes, not overlapping gray.
+ * @param count The number of pixels.
+ */
+inline void gray_to_rgba(const uint8_t *gray, uint8_t *rgba, size_t count) {
+    size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    // Doubling each byte twice makes four copies of it.
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+    for (; i + 16 <= count; i += 16) {
+        const __m128i source = _mm_loadu_si128((const __m128i *)(gray + i));
+        const __m128i low = _mm_unpacklo_epi8(source, source);
+        const __m128i high = _mm_unpackhi_epi8(source, source);
+
+        __m128i *out = (__m128i *)(rgba + i * 4);
+        _mm_storeu_si128(out + 0, _mm_or_si128(_mm_unpacklo_epi16(low, low), alpha));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_unpackhi_epi16(low, low), alpha));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_unpacklo_epi16(high, high), alpha));
+        _mm_storeu_si128(out + 3, _mm_or_si128(_mm_unpackhi_epi16(high, high), alpha));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        rgba[i * 4 + 0] = gray[i];
+        rgba[i * 4 + 1] = gray[i];
+        rgba[i * 4 + 2] = gray[i];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+/**
+ * @brief Expands gray and alpha pixels to RGBA8.
+ *
+ * @param gray_alpha count pixels of 2 bytes, gray then alpha.
+ * @param rgba Room for count pixels of 4 bytes, not overlapping gray_alpha.
+ * @param count The number of pixels.
+ */
+inline void gray_alpha_to_rgba(const uint8_t *gray_alpha, uint8_t *rgba, size_t count) {
+    size_t i = 0;
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+    const __m128i low = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+    const __m128i high = _mm_setr_epi8(8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+
+    for (; i + 8 <= count; i += 8) {
+        const __m128i source = _mm_loadu_si128((const __m128i *)(gray_alpha + i * 2));
+
+        __m128i *out = (__m128i *)(rgba + i * 4);
+        _mm_storeu_si128(out + 0, _mm_shuffle_epi8(source, low));
+        _mm_storeu_si128(out + 1, _mm_shuffle_epi8(source, high));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        rgba[i * 4 + 0] = gray_alpha[i * 2];
+        rgba[i * 4 + 1] = gray_alpha[i * 2];
+        rgba[i * 4 + 2] = gray_alpha[i * 2];
+        rgba[i * 4 + 3] = gray_alpha[i * 2 + 1];
+    }
+}
+
+/**
+ * @brief Converts pixels of 1 to 4 channels, as stbi_load returns them, to RGBA8.
+ *
+ * @param source count pixels of channels bytes.
+ * @param channels 1 for gray, 2 for gray and alpha, 3 for RGB or 4 for RGBA.
+ * @param rgba Room for count pixels of 4 bytes, not overlapping source.
+ * @param count The number of pixels.
+ * @return bool Whether the channel count was supported.
+ */
+inline bool to_rgba(const uint8_t *source, int channels, uint8_t *rgba, size_t count) {
+    switch (channels) {
+    case 1:
+        gray_to_rgba(source, rgba, count);
+        return true;
+    case 2:
+        gray_alpha_to_rgba(source, rgba, count);
+        return true;
+    case 3:
+        rgb_to_rgba(source, rgba, count);
+        return true;
+    case 4:
+        memcpy(rgba, source, count * 4);
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace pixels
+} // namespace engine
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <inttypes.h>
+#include <string.h>
+
+namespace engine {
+namespace radix_sort {
+
+// Maps a float to an unsigned integer that sorts in the same order, negative numbers included.
+inline uint32_t float_key(const float f) {
+    uint32_t bits = 0;
+    memcpy(&bits, &f, sizeof(float));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+/**
+ * @brief Sorts keys and their values with a stable LSD radix sort, 8 bits per pass.
+ * Passes where every key has the same byte are skipped, so narrow key ranges sort in fewer passes.
+ *
+ * @param keys The keys to sort, holds the sorted keys on return.
+ * @param values The values to sort along with the keys, usually indices. Holds the sorted values on return.
+ * @param temp_keys Scratch space for count keys.
+ * @param temp_values Scratch space for count values.
+ * @param count The number of keys.
+ */
+template <typename K>
+void sort(K *keys, uint32_t *values, K *temp_keys, uint32_t *temp_values, const uint32_t count) {
+    constexpr uint32_t passes = sizeof(K);
+
+    if (count < 2) {
+        return;
+    }
+
+    uint32_t histograms[passes][256] = {};
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const K key = keys[i];
+        for (uint32_t pass = 0; pass < passes; ++pass) {
+            ++histograms[pass][(key >> (pass * 8)) & 0xff];
+        }
+    }
+
+    K *src_keys = keys;
+    uint32_t *src_values = values;
+    K *dst_keys = temp_keys;
+    uint32_t *dst_values = temp_values;
+
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        uint32_t *histogram = histograms[pass];
+        const uint32_t shift = pass * 8;
+
+        // Every key has the same byte in this pass, the order wouldn't change.
+        if (histogram[(src_keys[0] >> shift) & 0xff] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < 256; ++bucket) {
+            const uint32_t bucket_count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_count;
+        }
+
+        for (uint32_t i = 0; i < count; ++i) {
+            const K key = src_keys[i];
+            const uint32_t destination = histogram[(key >> shift) & 0xff]++;
+            dst_keys[destination] = key;
+            dst_values[destination] = src_values[i];
+        }
+
+        K *swap_keys = src_keys;
+        src_keys = dst_keys;
+        dst_keys = swap_keys;
+
+        uint32_t *swap_values = src_values;
+        src_values = dst_values;
+        dst_values = swap_values;
+    }
+
+    if (src_keys != keys) {
+        memcpy(keys, src_keys, sizeof(K) * count);
+        memcpy(values, src_values, sizeof(uint32_t) * count);
+    }
+}
+
+} // namespace radix_sort
+} // namespace engine
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <inttypes.h>
+#include <string.h>
+
+namespace engine {
+
+// A segment of a skyline, the bottom edge of the packed rects over [x, x + width), y growing down the page.
+struct SkylineNode {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+};
+
+// Packs rects into a page bottom-left first along a skyline, the outline of what's packed so far. Fast and simple,
+// and dense when rects come sorted by height. Rects are never rotated or removed.
+struct SkylinePacker {
+    int32_t width = 0;
+    int32_t height = 0;
+    SkylineNode *nodes = nullptr; // Room for max_nodes, owned by the caller.
+    uint32_t node_count = 0;
+    uint32_t max_nodes = 0;
+    uint64_t used_area = 0; // The area of the packed rects.
+};
+
+namespace skyline_packer {
+
+// The number of nodes a packer of a page width needs, one per column at worst, and one more while inserting.
+constexpr uint32_t max_nodes(int32_t width) {
+    return (uint32_t)width + 1;
+}
+
+/**
+ * @brief Starts packing an empty page.
+ *
+ * @param packer The SkylinePacker.
+ * @param width The width of the page.
+ * @param height The height of the page.
+ * @param nodes Storage for the skyline, at least max_nodes(width).
+ * @param node_capacity The number of nodes in nodes.
+ */
+inline void init(SkylinePacker &packer, int32_t width, int32_t height, SkylineNode *nodes, uint32_t node_capacity) {
+    packer.width = width;
+    packer.height = height;
+    packer.nodes = nodes;
+    packer.max_nodes = node_capacity;
+    packer.node_count = 1;
+    packer.used_area = 0;
+    nodes[0] = {0, 0, width};
+}
+
+// Returns the y a rect of width w would rest at with its left edge on node index, -1 if it doesn't fit there.
+inline int32_t fit(const SkylinePacker &packer, uint32_t index, int32_t w, int32_t h) {
+    const int32_t x = packer.nodes[index].x;
+    if (x + w > packer.width) {
+        return -1;
+    }
+
+    int32_t y = 0;
+    int32_t remaining = w;
+    for (uint32_t i = index; remaining > 0; ++i) {
+        y = packer.nodes[i].y > y ? packer.nodes[i].y : y;
+        if (y + h > packer.height) {
+            return -1;
+        }
+
+        remaining -= packer.nodes[i].width;
+    }
+
+    return y;
+}
+
+/**
+ * @brief Packs a rect where its bottom edge ends up highest on the page, preferring the narrowest spot on ties.
+ *
+ * @param packer The SkylinePacker.
+ * @param w The width of the rect.
+ * @param h The height of the rect.
+ * @param x Set to the left edge of the packed rect.
+ * @param y Set to the top edge of the packed rect.
+ * @return bool Whether the rect fit in the page.
+ */
+inline bool pack(SkylinePacker &packer, int32_t w, int32_t h, int32_t &x, int32_t &y) {
+    if (w <= 0 || h <= 0) {
+        return false;
+    }
+
+    uint32_t best = UINT32_MAX;
+    int32_t best_bottom = INT32_MAX;
+    int32_t best_width = INT32_MAX;
+    int32_t best_y = 0;
+
+    for (uint32_t i = 0; i < packer.node_count; ++i) {
+        const int32_t node_y = fit(packer, i, w, h);
+        if (node_y < 0) {
+            continue;
+        }
+
+        const int32_t bottom = node_y + h;
+        if (bottom < best_bottom || (bottom == best_bottom && packer.nodes[i].width < best_width)) {
+            best = i;
+            best_bottom = bottom;
+            best_width = packer.nodes[i].width;
+            best_y = node_y;
+        }
+    }
+
+    if (best == UINT32_MAX || packer.node_count == packer.max_nodes) {
+        return false;
+    }
+
+    x = packer.nodes[best].x;
+    y = best_y;
+
+    // The rect's bottom edge becomes a new node, and the nodes it covers shrink or go.
+    memmove(&packer.nodes[best + 1], &packer.nodes[best], (packer.node_count - best) * sizeof(SkylineNode));
+    packer.nodes[best] = {x, best_bottom, w};
+    ++packer.node_count;
+
+    const uint32_t next = best + 1;
+    while (next < packer.node_count) {
+        SkylineNode &node = packer.nodes[next];
+        const int32_t covered = x + w - node.x;
+        if (covered <= 0) {
+            break;
+        }
+
+        if (covered < node.width) {
+            node.x += covered;
+            node.width -= covered;
+            break;
+        }
+
+        memmove(&packer.nodes[next], &packer.nodes[next + 1], (packer.node_count - next - 1) * sizeof(SkylineNode));
+        --packer.node_count;
+    }
+
+    // Neighbors at the same height merge, which keeps the skyline short.
+    for (uint32_t i = 0; i + 1 < packer.node_count;) {
+        if (packer.nodes[i].y == packer.nodes[i + 1].y) {
+            packer.nodes[i].width += packer.nodes[i + 1].width;
+            memmove(&packer.nodes[i + 1], &packer.nodes[i + 2], (packer.node_count - i - 2) * sizeof(SkylineNode));
+            --packer.node_count;
+        } else {
+            ++i;
+        }
+    }
+
+    packer.used_area += (uint64_t)w * (uint64_t)h;
+    return true;
+}
+
+// Returns the fraction of the page covered by packed rects.
+inline double occupancy(const SkylinePacker &packer) {
+    return (double)packer.used_area / ((double)packer.width * (double)packer.height);
+}
+
+} // namespace skyline_packer
+} // namespace engine
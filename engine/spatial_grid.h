@@ -0,0 +1,55 @@
+#pragma once
+
+#include <collection_types.h>
+#include <glm/glm.hpp>
+#include <inttypes.h>
+
+namespace engine {
+using namespace foundation;
+
+// The bounds of an item in a SpatialGrid and the range of cells it is stored in.
+struct GridItem {
+    glm::vec2 min;
+    glm::vec2 max;
+    glm::ivec2 cell_min;
+    glm::ivec2 cell_max;
+    bool oversized;
+};
+
+// A sparse uniform grid of axis aligned bounds, keyed by id, for finding the items overlapping a region without
+// visiting every item. Items spanning too many cells are kept in a separate list that every query checks.
+struct SpatialGrid {
+    SpatialGrid(Allocator &allocator, float cell_size = 256.0f);
+
+    Allocator &allocator;
+    float cell_size;
+    Hash<uint64_t> cells;     // A multihash map of cell keys to the ids of the items overlapping the cell.
+    Hash<GridItem> items;     // Item ids to their bounds.
+    Array<uint64_t> oversized; // Ids of items spanning more cells than worth storing.
+};
+
+namespace spatial_grid {
+
+// Inserts an item, or moves it if the id is already in the grid.
+void insert(SpatialGrid &grid, uint64_t id, glm::vec2 min, glm::vec2 max);
+
+// Removes an item.
+void remove(SpatialGrid &grid, uint64_t id);
+
+// Returns a pointer to the bounds of an item, nullptr if it isn't in the grid.
+const GridItem *find(const SpatialGrid &grid, uint64_t id);
+
+// Appends the ids of all items whose bounds overlap the rect [min, max]. Each id is appended once.
+void query(const SpatialGrid &grid, glm::vec2 min, glm::vec2 max, Array<uint64_t> &ids);
+
+// Appends the ids of all items whose bounds contain the point.
+void query_point(const SpatialGrid &grid, glm::vec2 point, Array<uint64_t> &ids);
+
+// Appends the ids of all items whose bounds overlap the circle. Each id is appended once.
+void query_radius(const SpatialGrid &grid, glm::vec2 center, float radius, Array<uint64_t> &ids);
+
+// Removes every item.
+void clear(SpatialGrid &grid);
+
+} // namespace spatial_grid
+} // namespace engine
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "radix_sort.inl"
+#include <inttypes.h>
+
+namespace engine {
+
+// A run of sorted sprites sharing an atlas, drawn with one draw call.
+struct SpriteBatch {
+    uint32_t atlas;
+    uint32_t first;
+    uint32_t count;
+};
+
+// Returns the key sprites are drawn in order of: by layer, then by depth, then grouped by atlas within equal depths.
+inline uint64_t sprite_sort_key(const uint16_t layer, const float z, const uint16_t atlas) {
+    return ((uint64_t)layer << 48) | ((uint64_t)radix_sort::float_key(z) << 16) | (uint64_t)atlas;
+}
+
+// Returns the atlas index of a sprite sort key.
+constexpr uint16_t sprite_sort_key_atlas(const uint64_t key) {
+    return (uint16_t)(key & 0xffff);
+}
+
+/**
+ * @brief Splits sorted sprites into batches, starting a new batch whenever the atlas changes.
+ *
+ * @param sorted_keys The sort keys of the sprites in draw order.
+ * @param count The number of sprites.
+ * @param batches The batches to write, must have room for count batches.
+ * @return uint32_t The number of batches, which is the number of draw calls.
+ */
+inline uint32_t batch_sprites(const uint64_t *sorted_keys, const uint32_t count, SpriteBatch *batches) {
+    uint32_t batch_count = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint16_t atlas = sprite_sort_key_atlas(sorted_keys[i]);
+
+        if (batch_count == 0 || batches[batch_count - 1].atlas != atlas) {
+            batches[batch_count].atlas = atlas;
+            batches[batch_count].first = i;
+            batches[batch_count].count = 0;
+            ++batch_count;
+        }
+
+        ++batches[batch_count - 1].count;
+    }
+
+    return batch_count;
+}
+
+} // namespace engine
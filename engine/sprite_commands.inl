@@ -0,0 +1,67 @@
+#pragma once
+
+#include "math.inl"
+#include "mpsc_queue.inl"
+#include <atomic>
+#include <inttypes.h>
+
+namespace engine {
+
+struct AtlasFrame;
+
+// A change to a sprite queued by transform_sprite and friends, applied by the next update_sprites or commit.
+struct SpriteCommand {
+    enum class Type : uint8_t {
+        Add,
+        Remove,
+        Transform,
+        Color,
+        Layer,
+        Parent,
+    };
+
+    Type type;
+    uint16_t atlas_index;
+    uint16_t layer;
+    uint64_t sprite_id;
+    uint64_t parent_id;
+    const AtlasFrame *atlas_frame;
+    math::Transform2D transform;
+    uint32_t color;
+};
+
+struct SpriteCommands {
+    static constexpr uint32_t capacity = 8192;
+
+    MPSCQueue<SpriteCommand, capacity> queue;
+    std::atomic<uint64_t> sprite_id_counter = {0};
+};
+
+namespace sprite_commands {
+
+// Passes the queued commands to apply in the order they were queued. Only one thread may drain at a time.
+template <typename Apply>
+void drain(SpriteCommands &commands, Apply apply) {
+    SpriteCommand command;
+    while (mpsc_queue::try_pop(commands.queue, command)) {
+        apply(command);
+    }
+}
+
+/**
+ * @brief Applies the queued commands, then runs the animation pass. update_sprites goes through this so the order is
+ * fixed: changes queued before the update apply first and running animations apply on top, as they did when
+ * transform_sprite and color_sprite changed sprites right away. Changes queued after the update apply on commit.
+ *
+ * @param commands The queued commands.
+ * @param apply Called with each command.
+ * @param animate Runs the animation pass.
+ */
+template <typename Apply, typename Animate>
+void update(SpriteCommands &commands, Apply apply, Animate animate) {
+    drain(commands, apply);
+    animate();
+}
+
+} // namespace sprite_commands
+} // namespace engine
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "math.inl"
+#include <inttypes.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace engine {
+
+/**
+ * @brief Writes the four vertices of a sprite's quad, the corners of the unit quad: origin, origin + x + y, origin + y
+ * and origin + x.
+ *
+ * @param vertices Room for four vertices.
+ * @param transform The world transform of the sprite.
+ * @param texture_coords The texture coords of the corners, in the same order.
+ * @param color The color, packed with color::pack_rgba8.
+ */
+inline void write_sprite_vertices(math::PackedVertex *vertices, const math::Transform2D &transform, const uint16_t (&texture_coords)[4][2], uint32_t color) {
+#if defined(__SSE2__) || defined(_M_X64)
+    // Both axes in one register, and the origin twice.
+    const __m128 axes = _mm_loadu_ps(&transform.x_axis.x);
+    const __m128 origin = _mm_castpd_ps(_mm_load1_pd((const double *)&transform.origin.x));
+    const __m128 swapped_axes = _mm_shuffle_ps(axes, axes, _MM_SHUFFLE(1, 0, 3, 2));
+    const __m128 diagonal = _mm_add_ps(axes, swapped_axes);
+
+    alignas(16) float corners[8];
+    _mm_store_ps(corners, _mm_add_ps(origin, _mm_movelh_ps(_mm_setzero_ps(), diagonal)));
+    _mm_store_ps(corners + 4, _mm_add_ps(origin, swapped_axes));
+#else
+    const glm::vec2 diagonal = transform.x_axis + transform.y_axis;
+    const float corners[8] = {
+        transform.origin.x, transform.origin.y,
+        transform.origin.x + diagonal.x, transform.origin.y + diagonal.y,
+        transform.origin.x + transform.y_axis.x, transform.origin.y + transform.y_axis.y,
+        transform.origin.x + transform.x_axis.x, transform.origin.y + transform.x_axis.y};
+#endif
+
+    for (int i = 0; i < 4; ++i) {
+        vertices[i].position = {corners[i * 2], corners[i * 2 + 1], transform.z};
+        vertices[i].texture_coords[0] = texture_coords[i][0];
+        vertices[i].texture_coords[1] = texture_coords[i][1];
+        vertices[i].color = color;
+    }
+}
+
+} // namespace engine
@@ -1,7 +1,11 @@
 #pragma once
 
 #include "color.inl"
+#include "keyframes.inl"
 #include "math.inl"
+#include "murmur_hash.inl"
+#include "sprite_batch.inl"
+#include "texture.h"
 #include <collection_types.h>
 #include <inttypes.h>
 #ifdef __APPLE__
@@ -20,21 +24,29 @@ using namespace math;
 struct Engine;
 struct Atlas;
 struct AtlasFrame;
+struct FenceRing;
 struct Shader;
+struct SpatialGrid;
+struct SpriteCommands;
+struct ThreadPool;
 
 struct Sprite {
     uint64_t id;
     const AtlasFrame *atlas_frame = nullptr;
-    glm::mat4 transform = glm::mat4(1.0f);
-    glm::vec4 color = {1.0f, 1.0f, 1.0f, 1.0f};
-    bool dirty = false;
+    Transform2D transform;                 // The world transform, including the parent's if it has one.
+    uint32_t color = 0xffffffff;           // Packed with color::pack_rgba8, the way the vertices take it.
+    uint16_t atlas_index = 0;              // Index into Sprites::atlases.
+    uint16_t layer = 0;                    // Sprites on higher layers draw on top regardless of depth.
+    bool dirty = false;                    // Whether the world transform changed in the commit running.
 };
 
 struct SpriteAnimation {
     enum class Type {
         Position,
         Rotation,
+        Scale,
         Color,
+        Frames,
     };
 
     uint64_t animation_id;
@@ -43,56 +55,230 @@ struct SpriteAnimation {
     float start_time;
     float duration;
     bool completed;
-    glm::mat4 from_transform;
-    glm::mat4 to_transform;
+    Transform2D from_transform;
+    Transform2D to_transform;
     glm::vec4 from_color;
     glm::vec4 to_color;
 };
 
-// A collection of sprites that share an atlas.
+// The running tweens of one animation channel, stored as a structure of arrays so updating a channel only touches
+// the fields it reads. Completed tweens are swap-removed, so the order isn't stable.
+template <typename T>
+struct SpriteTweens {
+    SpriteTweens(Allocator &allocator)
+    : animation_ids(allocator)
+    , sprite_ids(allocator)
+    , start_times(allocator)
+    , durations(allocator)
+    , easings(allocator)
+    , curves(allocator)
+    , from(allocator)
+    , to(allocator) {}
+
+    Array<uint64_t> animation_ids;
+    Array<uint64_t> sprite_ids;
+    Array<float> start_times;
+    Array<float> durations;
+    Array<Easing> easings;
+    Array<const CubicBezier *> curves; // Used with Easing::CubicBezier, not owned.
+    Array<T> from;
+    Array<T> to;
+};
+
+// The running keyframe tracks of one animation channel, stored as a structure of arrays. The keys of all tracks
+// share one array, each track owning a range of it in track order. Completed tracks are removed in one sweep per
+// update.
+template <typename T>
+struct SpriteTracks {
+    SpriteTracks(Allocator &allocator)
+    : animation_ids(allocator)
+    , sprite_ids(allocator)
+    , start_times(allocator)
+    , first_keys(allocator)
+    , key_counts(allocator)
+    , cursors(allocator)
+    , keys(allocator) {}
+
+    Array<uint64_t> animation_ids;
+    Array<uint64_t> sprite_ids;
+    Array<float> start_times;
+    Array<uint32_t> first_keys;
+    Array<uint32_t> key_counts;
+    Array<uint32_t> cursors; // The segment each track evaluated last, see keyframes::find_segment.
+    Array<Keyframe<T>> keys;
+};
+
+// The running flipbooks, which cycle sprites through atlas frames, stored as a structure of arrays. The frames of
+// all flipbooks share one array, each flipbook owning a range of it in flipbook order. Completed flipbooks are removed
+// in one sweep per update.
+struct SpriteFlipbooks {
+    SpriteFlipbooks(Allocator &allocator)
+    : animation_ids(allocator)
+    , sprite_ids(allocator)
+    , start_times(allocator)
+    , fps(allocator)
+    , loops(allocator)
+    , first_frames(allocator)
+    , frame_counts(allocator)
+    , current_frames(allocator)
+    , frames(allocator) {}
+
+    Array<uint64_t> animation_ids;
+    Array<uint64_t> sprite_ids;
+    Array<float> start_times;
+    Array<float> fps;
+    Array<bool> loops;
+    Array<uint32_t> first_frames;
+    Array<uint32_t> frame_counts;
+    Array<uint32_t> current_frames; // The frame each flipbook shows, so sprites are only touched when it changes.
+    Array<const AtlasFrame *> frames;
+};
+
+// The sprites attached to a parent, stored as a structure of arrays ordered so parents come before their children.
+// A commit computes the world transforms of dirty subtrees in one sweep over it.
+struct SpriteHierarchy {
+    SpriteHierarchy(Allocator &allocator)
+    : sprite_ids(allocator)
+    , parent_ids(allocator)
+    , local_transforms(allocator)
+    , dirty(allocator)
+    , indices(allocator)
+    , unordered(false) {}
+
+    Array<uint64_t> sprite_ids;
+    Array<uint64_t> parent_ids;
+    Array<Transform2D> local_transforms; // Relative to the parent.
+    Array<bool> dirty;                   // Whether the local transform changed since the last commit.
+    Hash<uint32_t> indices;              // Sprite ids to their index in the arrays.
+    bool unordered;                      // Whether parents changed since the arrays were last ordered.
+};
+
+// A collection of sprites drawn from one or more atlases, batched into as few draw calls as the draw order allows.
 struct Sprites {
-    Sprites(Allocator &allocator);
+    Sprites(Allocator &allocator, uint32_t capacity = 1024);
+
+    // Sprites drawn by an engine, which commit large batches on the engine's worker threads. Double buffered from
+    // the start when the engine has parallel_update, see swap_sprites.
+    Sprites(Allocator &allocator, const Engine &engine, uint32_t capacity = 1024);
     ~Sprites();
     
     Allocator &allocator;
-    Atlas *atlas;
+    Atlas *atlas;                          // The first atlas, the one add_sprite without an atlas index uses.
+    Array<Atlas *> atlases;
     Shader *shader;
-    Vertex *vertex_data;
+    PackedVertex *vertex_data;             // The persistently mapped vertex buffer, split into one region per fence in the ring.
+    uint32_t capacity;                     // The number of sprites a region holds, grows on commit when exceeded.
+    FenceRing *fences;                     // Guards the vertex buffer regions from being written while the GPU reads them.
+    ThreadPool *thread_pool;               // Spreads vertex generation of large commits across threads, the engine's when constructed with one. Not owned.
+    uint32_t committed_region;             // The region written by the last commit.
+    uint32_t render_region;                // The region render_sprites draws, published by the last swap.
+    uint32_t write_region;                 // When double buffered, the region the next commit writes, acquired by swap_sprites.
+    uint32_t requested_capacity;           // When double buffered, the capacity a commit ran out of, grown by swap_sprites.
+    bool double_buffered;                  // Set by the first swap_sprites, or on construction for a parallel_update engine. Commits then leave publishing and GL work to swaps.
+    bool committed;                        // Whether there's a commit not published yet.
     uint32_t vbo;
     uint32_t vao;
     uint32_t ebo;
 
     float time;
 
-    uint64_t sprite_id_counter;
     uint64_t animation_id_counter;
 
     std::mutex *sprites_mutex;
+    SpriteCommands *commands; // Changes queued without taking the mutex, applied by update_sprites and commit. Also hands out sprite ids.
     
     Array<Sprite> sprites;
-    Array<SpriteAnimation> animations;
+    Hash<uint32_t> sprite_indices;          // Sprite ids to their index in sprites.
+    SpatialGrid *grid;                      // The world space bounds of every sprite, for culling and queries.
+    SpriteHierarchy hierarchy;
+    SpriteTweens<glm::vec3> position_tweens;
+    SpriteTweens<float> rotation_tweens; // Radians around the z axis.
+    SpriteTweens<glm::vec2> scale_tweens;
+    SpriteTweens<glm::vec4> color_tweens;
+    SpriteTracks<glm::vec3> position_tracks;
+    SpriteTracks<float> rotation_tracks;
+    SpriteTracks<glm::vec2> scale_tracks;
+    SpriteTracks<glm::vec4> color_tracks;
+    SpriteFlipbooks flipbooks;
     Array<SpriteAnimation> done_animations; // The list of done animations since last frame
-    Hash<glm::mat4> transforms;             // A multihash map of sprite ids to a list of transforms waiting to be applied and cleared on commit_sprites.
+    Hash<Transform2D> transforms;           // A multihash map of sprite ids to a list of transforms waiting to be applied and cleared on commit_sprites.
+
+    // Scratch space for depth sorting in commit_sprites, kept between commits to avoid reallocating.
+    Array<uint64_t> sort_keys;
+    Array<uint32_t> sort_indices;
+    Array<uint64_t> visible_ids;
+
+    Array<uint32_t> draw_order;  // Indices into sprites of the sprites written by the last commit, in draw order.
+    Array<SpriteBatch> batches;        // The draw calls of the last commit, ranges of draw_order.
+    Array<SpriteBatch> render_batches; // The draw calls render_sprites issues, published by the last swap.
+    Array<uint32_t> render_textures;   // The texture of each render batch, read off the atlases when published.
 };
 
 // Initializes this Sprites with an atlas. Required before rendering.
-void init_sprites(Sprites &sprites, const char *atlas_filename);
+void init_sprites(Sprites &sprites, const char *atlas_filename, const TextureOptions &texture_options = TextureOptions());
+
+// Loads another atlas into this Sprites and returns its atlas index. Scenes zoomed out with zoom_camera read far less
+// of an atlas loaded with mipmaps and its padding in the texture options. Must be called on the thread owning the GL
+// context.
+uint16_t add_sprites_atlas(Sprites &sprites, const char *atlas_filename, const TextureOptions &texture_options = TextureOptions());
+
+// Adds an atlas made elsewhere, like a page of an AtlasBuilder, takes ownership of it and returns its atlas index.
+uint16_t add_sprites_atlas(Sprites &sprites, Atlas *atlas);
+
+// Grows the vertex buffers to hold at least `capacity` sprites. Must be called on the thread owning the GL context.
+void reserve_sprites(Sprites &sprites, uint32_t capacity);
 
 // Adds a sprite and returns a copy of the sprite.
 const Sprite add_sprite(Sprites &sprites, const char *sprite_name, glm::vec4 color = engine::color::white);
 
-// Remove sprite based on its id.
+// Adds a sprite from the atlas at `atlas_index` on a layer and returns a copy of the sprite.
+const Sprite add_sprite(Sprites &sprites, uint16_t atlas_index, const char *sprite_name, glm::vec4 color = engine::color::white, uint16_t layer = 0);
+
+// Adds a sprite by the id of its name, see hash_name, skipping hashing the name.
+const Sprite add_sprite(Sprites &sprites, uint16_t atlas_index, NameId sprite_name, glm::vec4 color = engine::color::white, uint16_t layer = 0);
+
+// Remove sprite based on its id. Applies the queued commands first, so it also removes a sprite queued for adding.
 void remove_sprite(Sprites &sprites, const uint64_t id);
 
+// Queues adding a sprite and returns its id, the sprite is added on next commit. Lock-free, safe to call from any
+// thread as long as no atlases are being added.
+uint64_t queue_add_sprite(Sprites &sprites, uint16_t atlas_index, const char *sprite_name, glm::vec4 color = engine::color::white, uint16_t layer = 0);
+
+// Queues adding a sprite by the id of its name, see queue_add_sprite and hash_name.
+uint64_t queue_add_sprite(Sprites &sprites, uint16_t atlas_index, NameId sprite_name, glm::vec4 color = engine::color::white, uint16_t layer = 0);
+
+// Queues removing a sprite, the sprite is removed on next commit. Lock-free, safe to call from any thread.
+void queue_remove_sprite(Sprites &sprites, const uint64_t id);
+
 // Returns a pointer to a sprite by its id.
 const Sprite *get_sprite(const Sprites &sprites, const uint64_t id);
 
-// Transforms a sprite. Will take effect on next commit;
+// Transforms a sprite. Will take effect on next commit. Lock-free, safe to call from any thread.
+void transform_sprite(Sprites &sprites, const uint64_t id, const Transform2D &transform);
+
+// Transforms a sprite by the 2D part and z translation of a 3D transform. See transform_sprite.
 void transform_sprite(Sprites &sprites, const uint64_t id, const glm::mat4 transform);
 
-// Updates color of sprite.
+// Updates color of sprite. Will take effect on next commit. Lock-free, safe to call from any thread.
 void color_sprite(Sprites &sprites, const uint64_t id, const glm::vec4 color);
 
+// Moves a sprite to a layer. Will take effect on next commit. Lock-free, safe to call from any thread.
+void layer_sprite(Sprites &sprites, const uint64_t id, const uint16_t layer);
+
+// Attaches a sprite to a parent, a parent_id of 0 detaches it. An attached sprite's current transform and later
+// transform_sprite calls are relative to its parent, and it follows the parent when it moves. Removing a parent
+// detaches its children where they are. Will take effect on next commit. Lock-free, safe to call from any thread.
+void parent_sprite(Sprites &sprites, const uint64_t id, const uint64_t parent_id);
+
+// Appends the ids of the sprites whose quads contain a point in world space, as of the last commit.
+void sprites_at_point(const Sprites &sprites, glm::vec2 point, Array<uint64_t> &ids);
+
+// Appends the ids of the sprites whose bounds overlap a rect in world space, as of the last commit.
+void sprites_in_rect(const Sprites &sprites, glm::vec2 min, glm::vec2 max, Array<uint64_t> &ids);
+
+// Appends the ids of the sprites whose bounds overlap a circle in world space, as of the last commit.
+void sprites_in_radius(const Sprites &sprites, glm::vec2 center, float radius, Array<uint64_t> &ids);
+
 // Returns the array of done animation since last frame.
 const Array<SpriteAnimation> &done_sprite_animations(Sprites &sprites);
 
@@ -104,9 +290,39 @@ const Array<SpriteAnimation> &done_sprite_animations(Sprites &sprites);
  * @param to_position The position to animate to.
  * @param duration The duration in seconds.
  * @param delay The delay before starting animation in seconds.
+ * @param easing The easing of the animation.
+ * @param curve The curve followed with Easing::CubicBezier, not owned, it has to outlive the animation.
  * @return uint64_t The id of the SpriteAnimation. 0 on errors.
  */
-uint64_t animate_sprite_position(Sprites &sprites, const uint64_t sprite_id, const glm::vec3 to_position, const float duration, const float delay = 0.0f);
+uint64_t animate_sprite_position(Sprites &sprites, const uint64_t sprite_id, const glm::vec3 to_position, const float duration, const float delay = 0.0f, const Easing easing = Easing::Linear, const CubicBezier *curve = nullptr);
+
+/**
+ * @brief Creates a sprite animation for rotation around the z axis.
+ *
+ * @param sprites The Sprites.
+ * @param sprite_id The sprite id
+ * @param to_rotation The rotation in radians to animate to.
+ * @param duration The duration in seconds.
+ * @param delay The delay before starting animation in seconds.
+ * @param easing The easing of the animation.
+ * @param curve The curve followed with Easing::CubicBezier, not owned, it has to outlive the animation.
+ * @return uint64_t The id of the SpriteAnimation. 0 on errors.
+ */
+uint64_t animate_sprite_rotation(Sprites &sprites, const uint64_t sprite_id, const float to_rotation, const float duration, const float delay = 0.0f, const Easing easing = Easing::Linear, const CubicBezier *curve = nullptr);
+
+/**
+ * @brief Creates a sprite animation for scale.
+ *
+ * @param sprites The Sprites.
+ * @param sprite_id The sprite id
+ * @param to_scale The scale to animate to.
+ * @param duration The duration in seconds.
+ * @param delay The delay before starting animation in seconds.
+ * @param easing The easing of the animation.
+ * @param curve The curve followed with Easing::CubicBezier, not owned, it has to outlive the animation.
+ * @return uint64_t The id of the SpriteAnimation. 0 on errors.
+ */
+uint64_t animate_sprite_scale(Sprites &sprites, const uint64_t sprite_id, const glm::vec2 to_scale, const float duration, const float delay = 0.0f, const Easing easing = Easing::Linear, const CubicBezier *curve = nullptr);
 
 /**
  * @brief Creates a sprite animation for color.
@@ -116,17 +332,78 @@ uint64_t animate_sprite_position(Sprites &sprites, const uint64_t sprite_id, con
  * @param to_color The color to animate to.
  * @param duration The duration in seconds.
  * @param delay The delay before starting animation in seconds.
+ * @param easing The easing of the animation.
+ * @param curve The curve followed with Easing::CubicBezier, not owned, it has to outlive the animation.
+ * @return uint64_t The id of the SpriteAnimation. 0 on errors.
+ */
+uint64_t animate_sprite_color(Sprites &sprites, const uint64_t sprite_id, const glm::vec4 to_color, const float duration, const float delay = 0.0f, const Easing easing = Easing::Linear, const CubicBezier *curve = nullptr);
+
+/**
+ * @brief Plays a keyframe track on a sprite's position. The keys are copied.
+ *
+ * @param sprites The Sprites.
+ * @param sprite_id The sprite id.
+ * @param keys The keys, sorted by time in seconds from the start of the track.
+ * @param key_count The number of keys.
+ * @param delay The delay before starting the track in seconds.
+ * @return uint64_t The id of the SpriteAnimation. 0 on errors.
+ */
+uint64_t play_sprite_position_track(Sprites &sprites, const uint64_t sprite_id, const Keyframe<glm::vec3> *keys, const uint32_t key_count, const float delay = 0.0f);
+
+// Plays a keyframe track of rotations in radians on a sprite. See play_sprite_position_track.
+uint64_t play_sprite_rotation_track(Sprites &sprites, const uint64_t sprite_id, const Keyframe<float> *keys, const uint32_t key_count, const float delay = 0.0f);
+
+// Plays a keyframe track on a sprite's scale. See play_sprite_position_track.
+uint64_t play_sprite_scale_track(Sprites &sprites, const uint64_t sprite_id, const Keyframe<glm::vec2> *keys, const uint32_t key_count, const float delay = 0.0f);
+
+// Plays a keyframe track on a sprite's color. See play_sprite_position_track.
+uint64_t play_sprite_color_track(Sprites &sprites, const uint64_t sprite_id, const Keyframe<glm::vec4> *keys, const uint32_t key_count, const float delay = 0.0f);
+
+/**
+ * @brief Plays a flipbook on a sprite, cycling it through atlas frames. The frames are looked up once, in the atlas
+ * of the sprite.
+ *
+ * @param sprites The Sprites.
+ * @param sprite_id The sprite id.
+ * @param frame_names The names of the frames in order.
+ * @param frame_count The number of frames.
+ * @param fps The frames per second.
+ * @param loop Whether to loop. Otherwise the animation is done once the last frame has been shown for a frame time.
+ * @param delay The delay before starting the flipbook in seconds.
  * @return uint64_t The id of the SpriteAnimation. 0 on errors.
  */
-uint64_t animate_sprite_color(Sprites &sprites, const uint64_t sprite_id, const glm::vec4 to_color, const float duration, const float delay = 0.0f);
+uint64_t animate_sprite_frames(Sprites &sprites, const uint64_t sprite_id, const char **frame_names, const uint32_t frame_count, const float fps, const bool loop = true, const float delay = 0.0f);
 
-// Updates animations.
+// Plays a flipbook through frames by the ids of their names, see animate_sprite_frames and hash_name.
+uint64_t animate_sprite_frames(Sprites &sprites, const uint64_t sprite_id, const NameId *frame_names, const uint32_t frame_count, const float fps, const bool loop = true, const float delay = 0.0f);
+
+// Applies the changes queued so far, then updates animations on top of them. Changes queued after apply on commit.
 void update_sprites(Sprites &sprites, float t, float dt);
 
 // Commits all dirty sprites.
 void commit_sprites(Sprites &sprites);
 
-// Renders the sprites.
+// Commits all dirty sprites, writing vertices only for the sprites overlapping the engine's camera view.
+void commit_sprites(Sprites &sprites, const Engine &engine);
+
+/**
+ * @brief Publishes the last commit to render_sprites. Must be called on the thread owning the GL context, while no
+ * commit or render is running, e.g. in the engine swap callback.
+ *
+ * Until the first swap, every commit is published right away. After it the Sprites are double buffered: commits
+ * may run on another thread while render_sprites draws the last published commit, and only swaps publish. A
+ * commit running out of room then leaves out the sprites drawn last, and the next swap grows the buffers. Sprites
+ * constructed with an engine that has parallel_update are double buffered from the start, as its first update may
+ * commit on the update thread before any swap.
+ *
+ * @param sprites The Sprites.
+ */
+void swap_sprites(Sprites &sprites);
+
+// Renders the sprites of the last published commit. Doesn't lock, so it can overlap a commit on another thread.
 void render_sprites(const Engine &engine, const Sprites &sprites);
 
+// Returns the number of draw calls render_sprites issues for the last published commit.
+uint32_t sprites_draw_calls(const Sprites &sprites);
+
 } // namespace engine
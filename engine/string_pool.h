@@ -0,0 +1,39 @@
+#pragma once
+
+#include "engine/murmur_hash.inl"
+#include <collection_types.h>
+#include <inttypes.h>
+
+namespace engine {
+using namespace foundation;
+
+// Interned strings stored back to back in one buffer and looked up by their NameId, instead of an allocation each.
+struct StringPool {
+    StringPool(Allocator &allocator);
+
+    Array<char> strings;    // The null terminated strings.
+    Hash<uint32_t> offsets; // Name ids to the offset of their string in strings.
+};
+
+namespace string_pool {
+
+// Returns the id of a string, the same as hash_name gives.
+NameId name_id(const char *string, uint32_t length);
+
+// Interns a string and returns its id. Interning a string again returns the same id without storing it again.
+NameId intern(StringPool &pool, const char *string, uint32_t length);
+
+// Interns a null terminated string and returns its id.
+NameId intern(StringPool &pool, const char *string);
+
+// Returns the interned string of an id, nullptr if no string with the id is interned.
+const char *get(const StringPool &pool, NameId id);
+
+// Reserves room for `count` strings of `size` bytes in total, not counting their null terminators.
+void reserve(StringPool &pool, uint32_t count, uint32_t size);
+
+// Removes every string.
+void clear(StringPool &pool);
+
+} // namespace string_pool
+} // namespace engine
@@ -8,8 +8,38 @@ class Allocator;
 
 namespace engine {
 
+// How a Texture is sampled.
+enum class TextureFilter {
+    Nearest,
+    Linear
+};
+
+// How a Texture is loaded.
+struct TextureOptions {
+    // Keeps the decoded pixels in a cache file next to the image, see texture_cache.inl, and loads from it with a single
+    // mapping instead of decoding while the image's size and modification time are unchanged.
+    bool cache = false;
+
+    // Sampling when zoomed in, one pixel covering several on screen.
+    TextureFilter mag_filter = TextureFilter::Nearest;
+
+    // Sampling when zoomed out. With mipmaps Linear also blends between levels.
+    TextureFilter min_filter = TextureFilter::Nearest;
+
+    // Generates box filtered mip levels on upload, see mipmap.inl, so zoomed out sprites sample smaller levels instead
+    // of aliasing across the full size one.
+    bool mipmaps = false;
+
+    // The transparent pixels between an atlas' frames, which limits the mip levels so frames don't bleed into each
+    // other. -1 when the texture isn't an atlas.
+    int32_t atlas_padding = -1;
+};
+
 struct Texture {
-    Texture(foundation::Allocator &allocator, const char *texture_filename);
+    Texture(foundation::Allocator &allocator, const char *texture_filename, const TextureOptions &options = TextureOptions());
+
+    // Wraps a texture uploaded elsewhere, like by a TextureLoader.
+    Texture(int width, int height, uint32_t texture);
 
     int width;
     int height;
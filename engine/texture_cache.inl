@@ -0,0 +1,72 @@
+#pragma once
+
+#include <inttypes.h>
+#include <string.h>
+
+namespace engine {
+
+// The header of a texture cache file, followed by width * height RGBA8 pixels, rows top to bottom. The file sits next
+// to its source image, so the source's path is part of the key along with its size and modification time.
+struct TextureCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    uint64_t source_modified;
+    uint32_t width;
+    uint32_t height;
+};
+
+static_assert(sizeof(TextureCacheHeader) == 32, "The pixels follow the header unpadded");
+
+namespace texture_cache {
+
+constexpr char magic[4] = {'C', 'T', 'E', 'X'};
+constexpr uint32_t version = 1;
+
+// The suffix added to the source image's filename to get its cache's.
+constexpr const char *suffix = ".texcache";
+
+// Fills in the header of a cache of pixels decoded from a source file of the given size and modification time.
+inline void init_header(TextureCacheHeader &header, uint32_t width, uint32_t height, uint64_t source_size, uint64_t source_modified) {
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.source_size = source_size;
+    header.source_modified = source_modified;
+    header.width = width;
+    header.height = height;
+}
+
+/**
+ * @brief Returns the pixels of a cache file, if it was made from the source file as it is now.
+ *
+ * @param data The cache file.
+ * @param size The size of the cache file.
+ * @param source_size The size of the source file now.
+ * @param source_modified The modification time of the source file now.
+ * @param width Set to the width of the pixels.
+ * @param height Set to the height of the pixels.
+ * @return const uint8_t * The RGBA8 pixels, nullptr if the cache is stale, truncated or from another version.
+ */
+inline const uint8_t *pixels(const char *data, uint64_t size, uint64_t source_size, uint64_t source_modified, uint32_t &width, uint32_t &height) {
+    if (size < sizeof(TextureCacheHeader)) {
+        return nullptr;
+    }
+
+    TextureCacheHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0
+        || header.version != version
+        || header.source_size != source_size
+        || header.source_modified != source_modified
+        || size != sizeof(TextureCacheHeader) + (uint64_t)header.width * header.height * 4) {
+        return nullptr;
+    }
+
+    width = header.width;
+    height = header.height;
+    return (const uint8_t *)data + sizeof(TextureCacheHeader);
+}
+
+} // namespace texture_cache
+} // namespace engine
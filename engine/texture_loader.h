@@ -0,0 +1,55 @@
+#pragma once
+
+#include <collection_types.h>
+#include <inttypes.h>
+
+namespace engine {
+using namespace foundation;
+
+struct LoadingTexture;
+struct Texture;
+struct ThreadPool;
+
+// A texture queued on a TextureLoader.
+typedef uint32_t TextureHandle;
+
+enum class TextureState {
+    Decoding,  // Queued or decoding on a worker thread.
+    Uploading, // Decoded to RGBA8, waiting for or partway through its upload.
+    Ready,
+    Failed,
+};
+
+// Loads textures without blocking the GL thread. Images are decoded to RGBA8 on the worker threads, then uploaded on
+// the GL thread through a pixel buffer object a strip of rows at a time, within a time budget per frame.
+struct TextureLoader {
+    TextureLoader(Allocator &allocator, ThreadPool &thread_pool);
+    ~TextureLoader();
+
+    Allocator &allocator;
+    ThreadPool &thread_pool;
+    Array<LoadingTexture *> *textures; // Indexed by TextureHandle.
+    uint32_t next_upload;              // The first texture that may still need uploading.
+    uint32_t pixel_buffer;             // The GL_PIXEL_UNPACK_BUFFER strips are staged in, created on the first upload.
+};
+
+// Queues decoding an image on the worker threads and returns its handle. Must be called on the GL thread.
+TextureHandle load_texture(TextureLoader &loader, const char *texture_filename);
+
+// Returns the state of a texture.
+TextureState texture_state(const TextureLoader &loader, TextureHandle handle);
+
+// Returns whether a texture is uploaded and can be drawn with.
+bool texture_ready(const TextureLoader &loader, TextureHandle handle);
+
+// Returns a texture once it's ready, nullptr before or if it failed to load. Owned by the loader.
+const Texture *loaded_texture(const TextureLoader &loader, TextureHandle handle);
+
+// Uploads decoded textures until budget_seconds have passed, at least one strip per call so uploads always progress.
+// Must be called on the GL thread, once per frame. Returns whether any texture is still loading.
+bool upload_textures(TextureLoader &loader, double budget_seconds);
+
+// Blocks until every queued texture is ready or failed, e.g. behind a loading screen. Must be called on the GL thread.
+void finish_textures(TextureLoader &loader);
+
+} // namespace engine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <collection_types.h>
+#include <inttypes.h>
+#ifdef __APPLE__
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#else
+
+namespace std {
+class condition_variable;
+class mutex;
+class thread;
+} // namespace std
+#endif
+
+namespace engine {
+using namespace foundation;
+
+struct ParallelFor;
+
+// A unit of work executed on a worker thread.
+struct Job {
+    void (*function)(void *data) = nullptr;
+    void *data = nullptr;
+};
+
+// A fixed set of worker threads consuming a shared job queue.
+struct ThreadPool {
+    // A thread_count of 0 uses one thread less than the number of hardware threads.
+    ThreadPool(Allocator &allocator, uint32_t thread_count = 0);
+    ~ThreadPool();
+
+    Allocator &allocator;
+    uint32_t thread_count;
+    bool stopping;
+
+    std::mutex *mutex;
+    std::condition_variable *condition;
+    Queue<Job> *jobs;
+    Array<std::thread *> *threads;
+    ParallelFor *free_parallel_fors; // The states of finished parallel_for calls, reused by the next ones.
+};
+
+// Queues a job to run on one of the worker threads.
+void submit(ThreadPool &pool, Job job);
+
+/**
+ * @brief Calls a function over the range [0, count) split into chunks, on the worker threads and the calling thread.
+ * Returns when every chunk is done. Runs everything on the calling thread if the range is smaller than two chunks.
+ * The calling thread takes whatever chunks no worker has started on, so calling it from a job, or while the workers
+ * are busy, doesn't wait on the queue.
+ *
+ * @param pool The ThreadPool.
+ * @param count The size of the range.
+ * @param min_chunk The smallest chunk of the range worth handing to another thread.
+ * @param function The function called with the data and each chunk [begin, end).
+ * @param data The data passed to the function.
+ */
+void parallel_for(ThreadPool &pool, uint32_t count, uint32_t min_chunk, void (*function)(void *data, uint32_t begin, uint32_t end), void *data);
+
+} // namespace engine
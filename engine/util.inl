@@ -37,4 +37,15 @@ void shift_pop(Array<T> &a, uint32_t index) {
     array::pop_back(a);
 }
 
+// Swaps the contents of two arrays without copying their elements.
+// Both arrays must use the same allocator.
+template <typename T>
+void swap(Array<T> &a, Array<T> &b) {
+    assert(a._allocator == b._allocator);
+
+    std::swap(a._size, b._size);
+    std::swap(a._capacity, b._capacity);
+    std::swap(a._data, b._data);
+}
+
 } // namespace foundation
@@ -1,152 +1,276 @@
 #include "engine/atlas.h"
+#include "engine/atlas_json.inl"
 #include "engine/file.h"
 #include "engine/log.h"
 #include "engine/math.inl"
 #include "engine/texture.h"
 
-#include <cassert>
-#include <cjson/cJSON.h>
 #include <collection_types.h>
 #include <hash.h>
 #include <memory.h>
-#include <murmur_hash.h>
+#include <stdio.h>
 #include <string_stream.h>
 #include <temp_allocator.h>
 
 #define __STDC_WANT_LIB_EXT1__ 1
 #include <string.h>
 
-namespace engine {
+#include <algorithm>
+#include <type_traits>
+
+namespace {
+using namespace engine;
 using namespace foundation;
 using namespace foundation::string_stream;
 
-Atlas::Atlas(foundation::Allocator &allocator, const char *atlas_filename)
-: allocator(allocator)
-, sprite_names(nullptr)
-, frames(nullptr)
-, texture(nullptr) {
-    sprite_names = MAKE_NEW(allocator, Array<Buffer *>, allocator);
-    frames = MAKE_NEW(allocator, Hash<AtlasFrame>, allocator);
-
-    string_stream::Buffer data(allocator);
+// The binary atlas format written by bake_atlas, in the byte order of the platform baking it, little endian in practice:
+//
+// BakedAtlasHeader
+// uint64_t keys[frame_count]         The murmur hashed frame names, sorted.
+// AtlasFrame frames[frame_count]     In the order of the keys.
+// uint32_t names[frame_count]        The offset of each frame's name in the string pool, in the order of the keys.
+// char strings[strings_size]         The string pool of null terminated names and the image filename.
+const char baked_atlas_magic[4] = {'C', 'A', 'T', 'L'};
+const uint32_t baked_atlas_version = 2;
+
+struct BakedAtlasHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t frame_count;
+    uint32_t image_filename; // Offset in the string pool.
+    uint32_t keys_offset;    // The offsets of the sections from the start of the file.
+    uint32_t frames_offset;
+    uint32_t names_offset;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+    uint32_t texture_width; // The size of the texture the texture coords were computed for.
+    uint32_t texture_height;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BakedAtlasHeader) % alignof(uint64_t) == 0, "The keys must be aligned");
+static_assert(std::is_trivially_copyable<AtlasFrame>::value && sizeof(AtlasFrame) == 84, "AtlasFrame is stored as is in baked atlases, bump baked_atlas_version when changing it");
+
+// A frame being baked.
+struct BakedFrame {
+    uint64_t key;
+    uint32_t name;  // Offset in the string pool.
+    uint32_t order; // The order in the JSON.
+    AtlasFrame frame;
+};
+
+// The corners of the sprites' unit quad in the order sprites writes vertices, y up.
+const int quad_corners[4][2] = {{0, 0}, {1, 1}, {0, 1}, {1, 0}};
+
+// Computes a frame's normalized texture region and the texture coords of its quad's corners. Rotated frames are stored
+// turned 90 degrees clockwise, so along the quad's x the texture runs top to bottom, and along its y left to right.
+void compute_texture_coords(AtlasFrame &frame, glm::ivec2 texture_size) {
+    const int region_width = frame.rotated ? frame.rect.size.y : frame.rect.size.x;
+    const int region_height = frame.rotated ? frame.rect.size.x : frame.rect.size.y;
+
+    frame.uv_min = {(float)frame.rect.origin.x / texture_size.x, (float)frame.rect.origin.y / texture_size.y};
+    frame.uv_max = {(float)(frame.rect.origin.x + region_width) / texture_size.x, (float)(frame.rect.origin.y + region_height) / texture_size.y};
+
+    const uint16_t left = math::pack_unorm16(frame.uv_min.x);
+    const uint16_t right = math::pack_unorm16(frame.uv_max.x);
+    const uint16_t top = math::pack_unorm16(frame.uv_min.y);
+    const uint16_t bottom = math::pack_unorm16(frame.uv_max.y);
+
+    for (int i = 0; i < 4; ++i) {
+        const int x = quad_corners[i][0];
+        const int y = quad_corners[i][1];
+
+        if (frame.rotated) {
+            frame.texture_coords[i][0] = y ? right : left;
+            frame.texture_coords[i][1] = x ? bottom : top;
+        } else {
+            frame.texture_coords[i][0] = x ? right : left;
+            frame.texture_coords[i][1] = y ? top : bottom;
+        }
+    }
+}
 
-    if (!file::read(data, atlas_filename)) {
-        log_fatal("Could not read atlas");
+// Parses a TexturePacker JSON atlas, passing the AtlasJsonMeta to on_meta and each frame with its name to on_frame.
+// Names aren't null terminated. The frames' texture coords are left for compute_texture_coords.
+template <typename OnMeta, typename OnFrame>
+void parse_json_atlas(const char *atlas_filename, OnMeta on_meta, OnFrame on_frame) {
+    file::MappedFile mapped;
+    if (!file::map(mapped, atlas_filename)) {
+        log_fatal("Could not read atlas %s", atlas_filename);
     }
 
-    const cJSON *json = cJSON_Parse(string_stream::c_str(data));
-    if (!json) {
-        const char *error_ptr = cJSON_GetErrorPtr();
-        if (error_ptr != NULL) {
-            log_fatal("Could not parse atlas %s:\n%s", atlas_filename, error_ptr);
-        } else {
-            log_fatal("Could not parse atlas %s: unknown error", atlas_filename);
-        }
+    const char *error = nullptr;
+    uint32_t error_offset = 0;
+
+    const bool parsed = atlas_json::parse(
+        mapped.data, (uint32_t)mapped.size, on_meta,
+        [&on_frame](const AtlasJsonFrame &json_frame) {
+            AtlasFrame frame = {};
+            frame.pivot = json_frame.pivot;
+            frame.rect = json_frame.rect;
+            frame.source_rect = json_frame.source_rect;
+            frame.source_size = json_frame.source_size;
+            frame.rotated = json_frame.rotated;
+            frame.trimmed = json_frame.trimmed;
+            on_frame(json_frame.name, json_frame.name_length, frame);
+        },
+        error, error_offset);
+
+    file::unmap(mapped);
+
+    if (!parsed) {
+        log_fatal("Could not parse atlas %s: %s at byte %u", atlas_filename, error, error_offset);
     }
+}
 
-    // meta
-    {
-        const cJSON *meta = cJSON_GetObjectItem(json, "meta");
-        if (!meta || !cJSON_IsObject(meta)) {
-            log_fatal("Could not parse atlas %s: missing \"meta\": {...}", atlas_filename);
-        }
+// Returns the index of a frame in a baked atlas, UINT32_MAX if it has no frame with the id.
+uint32_t baked_index(const Atlas &atlas, NameId id) {
+    const NameId *keys_end = atlas.baked_keys + atlas.baked_frame_count;
+    const NameId *found = std::lower_bound(atlas.baked_keys, keys_end, id);
+    return found != keys_end && *found == id ? (uint32_t)(found - atlas.baked_keys) : UINT32_MAX;
+}
 
-        const cJSON *image = cJSON_GetObjectItemCaseSensitive(meta, "image");
-        if (!image || !cJSON_IsString(image)) {
-            log_fatal("Could not parse atlas %s: meta missing \"image\"", atlas_filename);
-        }
+} // namespace
 
-        assert(image->valuestring);
-        const char *image_filename = image->valuestring;
-        texture = MAKE_NEW(allocator, Texture, allocator, image_filename);
+namespace engine {
+using namespace foundation;
+using namespace foundation::string_stream;
+
+Atlas::Atlas(foundation::Allocator &allocator, const char *atlas_filename, const TextureOptions &texture_options)
+: allocator(allocator)
+, sprite_names(nullptr)
+, frames(nullptr)
+, added_frames(nullptr)
+, baked(nullptr)
+, baked_keys(nullptr)
+, baked_frames(nullptr)
+, baked_names(nullptr)
+, baked_strings(nullptr)
+, baked_frame_count(0)
+, texture(nullptr) {
+    file::MappedFile mapped;
+    if (!file::map(mapped, atlas_filename)) {
+        log_fatal("Could not read atlas %s", atlas_filename);
     }
 
-    // frames
-    {
-        const cJSON *frames_item = cJSON_GetObjectItem(json, "frames");
-        if (!frames_item || !cJSON_IsArray(frames_item)) {
-            log_fatal("Could not parse atlas %s: missing \"frames\": [...]", atlas_filename);
+    if (mapped.size < sizeof(BakedAtlasHeader) || memcmp(mapped.data, baked_atlas_magic, sizeof(baked_atlas_magic)) != 0) {
+        file::unmap(mapped);
+
+        sprite_names = MAKE_NEW(allocator, StringPool, allocator);
+        frames = MAKE_NEW(allocator, Hash<AtlasFrame>, allocator);
+
+        parse_json_atlas(
+            atlas_filename,
+            [this, &texture_options](const AtlasJsonMeta &meta) {
+                TempAllocator256 ta;
+                Buffer image_filename(ta);
+                string_stream::push(image_filename, meta.image, meta.image_length);
+                texture = MAKE_NEW(this->allocator, Texture, this->allocator, c_str(image_filename), texture_options);
+            },
+            [this](const char *name, uint32_t length, const AtlasFrame &frame) {
+                hash::set(*this->frames, string_pool::intern(*sprite_names, name, length), frame);
+            });
+
+        // The meta may come after the frames, so the texture's size is known only now.
+        for (uint32_t i = 0; i < array::size(frames->_data); ++i) {
+            compute_texture_coords(frames->_data[i].value, {texture->width, texture->height});
         }
 
-        const cJSON *frame = nullptr;
-        cJSON_ArrayForEach(frame, frames_item) {
-            cJSON *filename = cJSON_GetObjectItemCaseSensitive(frame, "filename");
-            if (!filename || !cJSON_IsString(filename)) {
-                log_fatal("Could not parse atlas %s: frame missing \"filename\": ...", atlas_filename);
-            }
+        return;
+    }
 
-            cJSON *frame_rect = cJSON_GetObjectItemCaseSensitive(frame, "frame");
-            if (!frame_rect || !cJSON_IsObject(frame_rect)) {
-                log_fatal("Could not parse atlas %s: frame missing \"frame\": ...", atlas_filename);
-            }
+    const BakedAtlasHeader *header = (const BakedAtlasHeader *)mapped.data;
+    if (header->version != baked_atlas_version) {
+        log_fatal("Could not load atlas %s: baked with version %u, expected version %u", atlas_filename, header->version, baked_atlas_version);
+    }
 
-            cJSON *x = cJSON_GetObjectItemCaseSensitive(frame_rect, "x");
-            if (!x || !cJSON_IsNumber(x)) {
-                log_fatal("Could not parse atlas %s: frame missing \"x\": ...", atlas_filename);
-            }
+    const uint64_t frame_count = header->frame_count;
+    if (header->keys_offset + frame_count * sizeof(uint64_t) > mapped.size
+        || header->frames_offset + frame_count * sizeof(AtlasFrame) > mapped.size
+        || header->names_offset + frame_count * sizeof(uint32_t) > mapped.size
+        || (uint64_t)header->strings_offset + header->strings_size > mapped.size
+        || header->keys_offset % alignof(uint64_t) != 0
+        || header->frames_offset % alignof(AtlasFrame) != 0
+        || header->names_offset % alignof(uint32_t) != 0
+        || header->image_filename >= header->strings_size
+        || mapped.data[header->strings_offset + header->strings_size - 1] != '\0') {
+        log_fatal("Could not load atlas %s: truncated or corrupt", atlas_filename);
+    }
 
-            cJSON *y = cJSON_GetObjectItemCaseSensitive(frame_rect, "y");
-            if (!y || !cJSON_IsNumber(y)) {
-                log_fatal("Could not parse atlas %s: frame missing \"y\": ...", atlas_filename);
-            }
+    baked = MAKE_NEW(allocator, file::MappedFile, mapped);
+    baked_keys = (const NameId *)(mapped.data + header->keys_offset);
+    baked_frames = (const AtlasFrame *)(mapped.data + header->frames_offset);
+    baked_names = (const uint32_t *)(mapped.data + header->names_offset);
+    baked_strings = mapped.data + header->strings_offset;
+    baked_frame_count = header->frame_count;
 
-            cJSON *w = cJSON_GetObjectItemCaseSensitive(frame_rect, "w");
-            if (!w || !cJSON_IsNumber(w)) {
-                log_fatal("Could not parse atlas %s: frame missing \"w\": ...", atlas_filename);
-            }
+    const char *image_filename = mapped.data + header->strings_offset + header->image_filename;
+    texture = MAKE_NEW(allocator, Texture, allocator, image_filename, texture_options);
 
-            cJSON *h = cJSON_GetObjectItemCaseSensitive(frame_rect, "h");
-            if (!h || !cJSON_IsNumber(h)) {
-                log_fatal("Could not parse atlas %s: frame missing \"h\": ...", atlas_filename);
-            }
+    if ((uint32_t)texture->width != header->texture_width || (uint32_t)texture->height != header->texture_height) {
+        log_fatal("Could not load atlas %s: baked for a %ux%u texture but %s is %dx%d, bake it again", atlas_filename, header->texture_width, header->texture_height, image_filename, texture->width, texture->height);
+    }
+}
 
-            glm::vec2 pv = {0.5f, 0.5f};
+Atlas::Atlas(foundation::Allocator &allocator, Texture *texture)
+: allocator(allocator)
+, sprite_names(nullptr)
+, frames(nullptr)
+, added_frames(nullptr)
+, baked(nullptr)
+, baked_keys(nullptr)
+, baked_frames(nullptr)
+, baked_names(nullptr)
+, baked_strings(nullptr)
+, baked_frame_count(0)
+, texture(texture) {
+    sprite_names = MAKE_NEW(allocator, StringPool, allocator);
+    frames = MAKE_NEW(allocator, Hash<AtlasFrame>, allocator);
+}
 
-            cJSON *pivot = cJSON_GetObjectItemCaseSensitive(frame, "pivot");
-            if (pivot && cJSON_IsObject(pivot)) {
-                cJSON *pvx = cJSON_GetObjectItemCaseSensitive(pivot, "x");
-                if (!pvx || !cJSON_IsNumber(pvx)) {
-                    log_fatal("Could not parse atlas %s: frame pivot missing \"x\": ...", atlas_filename);
-                }
+Atlas::~Atlas() {
+    if (added_frames) {
+        for (const Hash<AtlasFrame *>::Entry *entry = hash::begin(*added_frames); entry != hash::end(*added_frames); ++entry) {
+            MAKE_DELETE(allocator, AtlasFrame, entry->value);
+        }
 
-                cJSON *pvy = cJSON_GetObjectItemCaseSensitive(pivot, "y");
-                if (!pvy || !cJSON_IsNumber(pvy)) {
-                    log_fatal("Could not parse atlas %s: frame pivot missing \"y\": ...", atlas_filename);
-                }
+        MAKE_DELETE(allocator, Hash, added_frames);
+    }
 
-                pv.x = (float)pvx->valuedouble;
-                pv.y = (float)pvy->valuedouble;
-            }
+    MAKE_DELETE(allocator, StringPool, sprite_names);
+    MAKE_DELETE(allocator, Hash, frames);
+
+    if (baked) {
+        file::unmap(*baked);
+        MAKE_DELETE(allocator, MappedFile, baked);
+    }
 
-            math::Rect r;
-            r.origin.x = x->valueint;
-            r.origin.y = y->valueint;
-            r.size.x = w->valueint;
-            r.size.y = h->valueint;
+    MAKE_DELETE(allocator, Texture, texture);
+}
 
-            AtlasFrame fr;
-            fr.pivot = pv;
-            fr.rect = r;
+const AtlasFrame *add_atlas_frame(Atlas &atlas, const char *sprite_name, const AtlasFrame &frame) {
+    if (atlas.baked) {
+        log_fatal("Could not add frame %s: baked atlases can't be added to", sprite_name);
+    }
 
-            Buffer *sprite_name = MAKE_NEW(allocator, Buffer, allocator);
-            *sprite_name << filename->valuestring;
-            array::push_back(*sprite_names, sprite_name);
+    const NameId id = string_pool::intern(*atlas.sprite_names, sprite_name, (uint32_t)strlen(sprite_name));
+    if (multi_hash::find_first(*atlas.frames, id)) {
+        log_fatal("Could not add frame %s: the atlas already has it from its JSON", sprite_name);
+    }
 
-            uint64_t key = murmur_hash_64(c_str(*sprite_name), array::size(*sprite_name), 0);
-            hash::set(*this->frames, key, fr);
-        }
+    if (!atlas.added_frames) {
+        atlas.added_frames = MAKE_NEW(atlas.allocator, Hash<AtlasFrame *>, atlas.allocator);
     }
-}
 
-Atlas::~Atlas() {
-    for (uint32_t i = 0; i < array::size(*sprite_names); ++i) {
-        Buffer *b = (*sprite_names)[i];
-        MAKE_DELETE(allocator, Buffer, b);
+    AtlasFrame *added = hash::get(*atlas.added_frames, id, (AtlasFrame *)nullptr);
+    if (!added) {
+        added = MAKE_NEW(atlas.allocator, AtlasFrame);
+        hash::set(*atlas.added_frames, id, added);
     }
 
-    MAKE_DELETE(allocator, Array, sprite_names);
-    MAKE_DELETE(allocator, Hash, frames);
-    MAKE_DELETE(allocator, Texture, texture);
+    *added = frame;
+    compute_texture_coords(*added, {atlas.texture->width, atlas.texture->height});
+    return added;
 }
 
 const AtlasFrame *atlas_frame(const Atlas &atlas, const char *sprite_name) {
@@ -154,14 +278,30 @@ const AtlasFrame *atlas_frame(const Atlas &atlas, const char *sprite_name) {
         return nullptr;
     }
 
-    uint64_t key = murmur_hash_64(sprite_name, (uint32_t)strlen(sprite_name), 0);
-    for (auto i = hash::begin(*atlas.frames); i != hash::end(*atlas.frames); ++i) {
-        if (i->key == key) {
-            return &(i->value);
-        }
+    return atlas_frame(atlas, string_pool::name_id(sprite_name, (uint32_t)strlen(sprite_name)));
+}
+
+const AtlasFrame *atlas_frame(const Atlas &atlas, NameId id) {
+    if (atlas.baked) {
+        const uint32_t index = baked_index(atlas, id);
+        return index != UINT32_MAX ? &atlas.baked_frames[index] : nullptr;
     }
 
-    return nullptr;
+    const Hash<AtlasFrame>::Entry *entry = multi_hash::find_first(*atlas.frames, id);
+    if (entry) {
+        return &entry->value;
+    }
+
+    return atlas.added_frames ? hash::get(*atlas.added_frames, id, (AtlasFrame *)nullptr) : nullptr;
+}
+
+const char *atlas_frame_name(const Atlas &atlas, NameId id) {
+    if (atlas.baked) {
+        const uint32_t index = baked_index(atlas, id);
+        return index != UINT32_MAX ? atlas.baked_strings + atlas.baked_names[index] : nullptr;
+    }
+
+    return string_pool::get(*atlas.sprite_names, id);
 }
 
 const math::Rect *atlas_rect(const Atlas &atlas, const char *sprite_name) {
@@ -173,4 +313,91 @@ const math::Rect *atlas_rect(const Atlas &atlas, const char *sprite_name) {
     return &frame->rect;
 }
 
+void bake_atlas(Allocator &allocator, const char *atlas_filename, Buffer &baked) {
+    Array<BakedFrame> baked_frames(allocator);
+    Buffer strings(allocator);
+    uint32_t image_filename = 0;
+    glm::ivec2 texture_size = {0, 0};
+
+    auto add_string = [&strings](const char *string, uint32_t length) {
+        const uint32_t offset = array::size(strings);
+        string_stream::push(strings, string, length);
+        array::push_back(strings, '\0');
+        return offset;
+    };
+
+    parse_json_atlas(
+        atlas_filename,
+        [&](const AtlasJsonMeta &meta) {
+            image_filename = add_string(meta.image, meta.image_length);
+            texture_size = meta.size;
+        },
+        [&](const char *name, uint32_t length, const AtlasFrame &frame) {
+            BakedFrame baked_frame;
+            baked_frame.key = string_pool::name_id(name, length);
+            baked_frame.name = add_string(name, length);
+            baked_frame.order = array::size(baked_frames);
+            baked_frame.frame = frame;
+            array::push_back(baked_frames, baked_frame);
+        });
+
+    if (texture_size.x <= 0 || texture_size.y <= 0) {
+        log_fatal("Could not bake atlas %s: meta missing the image \"size\"", atlas_filename);
+    }
+
+    for (uint32_t i = 0; i < array::size(baked_frames); ++i) {
+        compute_texture_coords(baked_frames[i].frame, texture_size);
+    }
+
+    std::sort(array::begin(baked_frames), array::end(baked_frames), [](const BakedFrame &a, const BakedFrame &b) {
+        return a.key < b.key || (a.key == b.key && a.order < b.order);
+    });
+
+    // A later frame with the same name replaces an earlier one, like when loading the JSON. Different names with the
+    // same key can't both be looked up.
+    uint32_t frame_count = 0;
+    for (uint32_t i = 0; i < array::size(baked_frames); ++i) {
+        if (frame_count > 0 && baked_frames[frame_count - 1].key == baked_frames[i].key) {
+            const char *name = array::begin(strings) + baked_frames[i].name;
+            const char *previous_name = array::begin(strings) + baked_frames[frame_count - 1].name;
+            if (strcmp(name, previous_name) != 0) {
+                log_fatal("Could not bake atlas %s: frames %s and %s hash to the same key", atlas_filename, previous_name, name);
+            }
+
+            baked_frames[frame_count - 1] = baked_frames[i];
+        } else {
+            baked_frames[frame_count++] = baked_frames[i];
+        }
+    }
+
+    BakedAtlasHeader header;
+    memcpy(header.magic, baked_atlas_magic, sizeof(header.magic));
+    header.version = baked_atlas_version;
+    header.frame_count = frame_count;
+    header.image_filename = image_filename;
+    header.keys_offset = sizeof(BakedAtlasHeader);
+    header.frames_offset = header.keys_offset + frame_count * sizeof(uint64_t);
+    header.names_offset = header.frames_offset + frame_count * sizeof(AtlasFrame);
+    header.strings_offset = header.names_offset + frame_count * sizeof(uint32_t);
+    header.strings_size = array::size(strings);
+    header.texture_width = (uint32_t)texture_size.x;
+    header.texture_height = (uint32_t)texture_size.y;
+    header.reserved = 0;
+
+    array::resize(baked, header.strings_offset + header.strings_size);
+    memcpy(array::begin(baked), &header, sizeof(header));
+
+    uint64_t *keys = (uint64_t *)(array::begin(baked) + header.keys_offset);
+    AtlasFrame *frames = (AtlasFrame *)(array::begin(baked) + header.frames_offset);
+    uint32_t *names = (uint32_t *)(array::begin(baked) + header.names_offset);
+
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        keys[i] = baked_frames[i].key;
+        frames[i] = baked_frames[i].frame;
+        names[i] = baked_frames[i].name;
+    }
+
+    memcpy(array::begin(baked) + header.strings_offset, array::begin(strings), header.strings_size);
+}
+
 } // namespace engine
@@ -0,0 +1,116 @@
+#include "engine/atlas_builder.h"
+#include "engine/atlas.h"
+#include "engine/log.h"
+#include "engine/sprites.h"
+#include "engine/texture.h"
+
+#include <array.h>
+#include <glad/glad.h>
+#include <memory.h>
+#include <string.h>
+
+namespace {
+using namespace engine;
+
+// Adds an empty page, a transparent texture in an atlas of the Sprites.
+AtlasBuilderPage &add_page(AtlasBuilder &builder) {
+    const uint32_t page_bytes = (uint32_t)builder.page_size * (uint32_t)builder.page_size * 4;
+    void *transparent = builder.allocator.allocate(page_bytes);
+    memset(transparent, 0, page_bytes);
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, builder.page_size, builder.page_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, transparent);
+
+    builder.allocator.deallocate(transparent);
+
+    // Owned by the Sprites from here on, which deletes its atlases with its own allocator.
+    Allocator &sprites_allocator = builder.sprites.allocator;
+    Texture *page_texture = MAKE_NEW(sprites_allocator, Texture, builder.page_size, builder.page_size, texture);
+    Atlas *atlas = MAKE_NEW(sprites_allocator, Atlas, sprites_allocator, page_texture);
+
+    const uint32_t max_nodes = skyline_packer::max_nodes(builder.page_size);
+    array::resize(*builder.nodes, array::size(*builder.nodes) + max_nodes);
+
+    // The skylines may have moved with the nodes, point every packer at its own again.
+    for (uint32_t i = 0; i < array::size(*builder.pages); ++i) {
+        (*builder.pages)[i].packer.nodes = array::begin(*builder.nodes) + i * max_nodes;
+    }
+
+    // The packed area is inset by the padding, and each image packs with the padding on its right and bottom, so
+    // images keep padding pixels from each other and the page edges.
+    AtlasBuilderPage page;
+    page.atlas_index = add_sprites_atlas(builder.sprites, atlas);
+    const int32_t packed_size = builder.page_size - builder.padding;
+    skyline_packer::init(page.packer, packed_size, packed_size, array::end(*builder.nodes) - max_nodes, max_nodes);
+    array::push_back(*builder.pages, page);
+
+    return array::back(*builder.pages);
+}
+
+} // namespace
+
+namespace engine {
+
+AtlasBuilder::AtlasBuilder(Allocator &allocator, Sprites &sprites, int32_t page_size, int32_t padding)
+: allocator(allocator)
+, sprites(sprites)
+, page_size(page_size)
+, padding(padding)
+, pages(nullptr)
+, nodes(nullptr) {
+    pages = MAKE_NEW(allocator, Array<AtlasBuilderPage>, allocator);
+    nodes = MAKE_NEW(allocator, Array<SkylineNode>, allocator);
+}
+
+AtlasBuilder::~AtlasBuilder() {
+    MAKE_DELETE(allocator, Array, nodes);
+    MAKE_DELETE(allocator, Array, pages);
+}
+
+uint16_t add_atlas_image(AtlasBuilder &builder, const char *sprite_name, const uint8_t *rgba, int32_t width, int32_t height, glm::vec2 pivot) {
+    const int32_t max_size = builder.page_size - builder.padding * 2;
+    if (width <= 0 || height <= 0 || width > max_size || height > max_size) {
+        log_fatal("Could not add image %s: %dx%d doesn't fit pages of %d with %d padding", sprite_name, width, height, builder.page_size, builder.padding);
+    }
+
+    int32_t x = 0;
+    int32_t y = 0;
+    AtlasBuilderPage *page = nullptr;
+
+    for (uint32_t i = 0; i < array::size(*builder.pages); ++i) {
+        if (skyline_packer::pack((*builder.pages)[i].packer, width + builder.padding, height + builder.padding, x, y)) {
+            page = &(*builder.pages)[i];
+            break;
+        }
+    }
+
+    if (!page) {
+        page = &add_page(builder);
+        skyline_packer::pack(page->packer, width + builder.padding, height + builder.padding, x, y);
+    }
+
+    x += builder.padding;
+    y += builder.padding;
+
+    Atlas *atlas = builder.sprites.atlases[page->atlas_index];
+
+    glBindTexture(GL_TEXTURE_2D, atlas->texture->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+
+    AtlasFrame frame = {};
+    frame.pivot = pivot;
+    frame.rect = {{x, y}, {width, height}};
+    frame.source_rect = {{0, 0}, {width, height}};
+    frame.source_size = {width, height};
+    add_atlas_frame(*atlas, sprite_name, frame);
+
+    return page->atlas_index;
+}
+
+} // namespace engine
@@ -5,6 +5,7 @@
 #include "engine/ini.h"
 #include "engine/log.h"
 #include "engine/math.inl"
+#include "engine/pixels.inl"
 #include "engine/shader.h"
 #include "engine/stb_image.h"
 
@@ -211,24 +212,8 @@ void init_canvas(int32_t width, int32_t height, Canvas &canvas, const ini_t *con
         canvas.sprites_data_width = sprites_width;
         array::resize(canvas.sprites_data, sprites_width * sprites_height * 4);
 
-        if (channels == 4) {
-            memcpy(array::begin(canvas.sprites_data), data, sprites_width * sprites_height * 4);
-        } else {
-            for (int x = 0; x < sprites_width; ++x) {
-                for (int y = 0; y < sprites_height; ++y) {
-                    if (channels == 3) {
-                        array::push_back(canvas.sprites_data, data[(y * sprites_width + x) * 3 + 0]);
-                        array::push_back(canvas.sprites_data, data[(y * sprites_width + x) * 3 + 1]);
-                        array::push_back(canvas.sprites_data, data[(y * sprites_width + x) * 3 + 2]);
-                        array::push_back(canvas.sprites_data, (unsigned char)255);
-                    } else if (channels == 1) {
-                        array::push_back(canvas.sprites_data, data[y * sprites_width + x]);
-                        array::push_back(canvas.sprites_data, data[y * sprites_width + x]);
-                        array::push_back(canvas.sprites_data, data[y * sprites_width + x]);
-                        array::push_back(canvas.sprites_data, (unsigned char)255);
-                    }
-                }
-            }
+        if (!engine::pixels::to_rgba(data, channels, array::begin(canvas.sprites_data), (size_t)sprites_width * sprites_height)) {
+            log_fatal("Couldn't load texture %s: unsupported %d channels", sprites_filename, channels);
         }
 
         stbi_image_free(data);
@@ -433,7 +418,7 @@ void print(const Canvas &canvas, const char *printer) {
 
     // Clean up
     DeleteDC(printerDC);
-#elif
+#else
     log_error("Platform not supported");
 #endif
 
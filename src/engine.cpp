@@ -7,9 +7,12 @@
 #include "engine/math.inl"
 #include "engine/shader.h"
 #include "engine/texture.h"
+#include "engine/texture_loader.h"
+#include "engine/thread_pool.h"
 
 #include <GLFW/glfw3.h>
 #include <cassert>
+#include <condition_variable>
 #include <fstream>
 #include <functional>
 #include <glad/glad.h>
@@ -18,9 +21,11 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <memory.h>
+#include <mutex>
 #include <stdlib.h>
 #include <string_stream.h>
 #include <temp_allocator.h>
+#include <thread>
 
 #if defined(SUPERLUMINAL)
 #include <Superluminal/PerformanceAPI.h>
@@ -35,8 +40,6 @@ namespace {
 using namespace foundation;
 using namespace string_stream;
 
-GLsync gl_lock;
-
 void glfw_error_callback(int error, const char *description) {
     log_error("GLFW error %d: %s\n", error, description);
 }
@@ -174,25 +177,6 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
     glViewport(vp_x, vp_y, vp_width, vp_height);
 }
 
-void lock_buffer() {
-    if (gl_lock) {
-        glDeleteSync(gl_lock);
-    }
-
-    gl_lock = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-}
-
-void wait_buffer() {
-    if (gl_lock) {
-        while (true) {
-            GLenum wait_return = glClientWaitSync(gl_lock, GL_SYNC_FLUSH_COMMANDS_BIT, 1);
-            if (wait_return == GL_ALREADY_SIGNALED || wait_return == GL_CONDITION_SATISFIED) {
-                return;
-            }
-        }
-    }
-}
-
 } // namespace
 
 namespace engine {
@@ -209,12 +193,16 @@ Engine::Engine(Allocator &allocator, const char *config_path)
 , window_resized(false)
 , target_aspect_ratio(1.0f)
 , input(nullptr)
+, thread_pool(nullptr)
+, texture_loader(nullptr)
+, texture_upload_budget(0.002)
 , camera_zoom(1.0f)
 , render_scale(1)
 , camera_offset({0, 0})
 , terminating(false)
 , wait_vsync(true)
-, fps_limit(0) {
+, fps_limit(0)
+, parallel_update(false) {
     using namespace foundation::string_stream;
 
     TempAllocator1024 ta;
@@ -222,6 +210,7 @@ Engine::Engine(Allocator &allocator, const char *config_path)
     int window_width = 0;
     int window_height = 0;
     bool always_on_top = false;
+    uint32_t worker_threads = 0;
     Buffer window_title(ta);
     Buffer window_icon(ta);
 
@@ -306,6 +295,35 @@ Engine::Engine(Allocator &allocator, const char *config_path)
             });
         }
 
+        if (config::has_property(ini, "engine", "worker_threads")) {
+            read_property("engine", "worker_threads", [&worker_threads](const char *property) {
+                // 0 uses one thread less than the number of hardware threads, see ThreadPool.
+                char *end = nullptr;
+                const long threads = strtol(property, &end, 10);
+                if (end == property || *end != '\0' || threads < 0 || threads > 256) {
+                    log_fatal("Invalid config file, [engine] worker_threads must be from 0 to 256, not %s", property);
+                }
+
+                worker_threads = (uint32_t)threads;
+            });
+        }
+
+        if (config::has_property(ini, "engine", "texture_upload_ms")) {
+            read_property("engine", "texture_upload_ms", [this](const char *property) {
+                this->texture_upload_budget = atof(property) / 1000.0;
+            });
+        }
+
+        if (config::has_property(ini, "engine", "parallel_update")) {
+            read_property("engine", "parallel_update", [this](const char *property) {
+                if (strcmp("true", property) == 0) {
+                    this->parallel_update = true;
+                } else {
+                    this->parallel_update = false;
+                }
+            });
+        }
+
         if (config::has_property(ini, "engine", "window_icon")) {
             read_property("engine", "window_icon", [&window_icon](const char *property) {
                 window_icon << property;
@@ -387,6 +405,8 @@ Engine::Engine(Allocator &allocator, const char *config_path)
     }
 
     input = MAKE_NEW(allocator, Input, allocator, glfw_window);
+    thread_pool = MAKE_NEW(allocator, ThreadPool, allocator, worker_threads);
+    texture_loader = MAKE_NEW(allocator, TextureLoader, allocator, *thread_pool);
 
     // imgui
     {
@@ -404,6 +424,8 @@ Engine::Engine(Allocator &allocator, const char *config_path)
 
 Engine::~Engine() {
     MAKE_DELETE(allocator, Input, input);
+    MAKE_DELETE(allocator, TextureLoader, texture_loader);
+    MAKE_DELETE(allocator, ThreadPool, thread_pool);
 
     // imgui
     {
@@ -420,8 +442,6 @@ Engine::~Engine() {
 }
 
 void render(Engine &engine) {
-    wait_buffer();
-
     glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "render engine");
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -452,11 +472,42 @@ void render(Engine &engine) {
 
     glPopDebugGroup();
 
-    lock_buffer();
-
     glfwSwapBuffers(engine.glfw_window);
 }
 
+// Runs the updates while the main thread renders. It's a thread of its own rather than a job on the thread pool, so
+// an update never queues behind the jobs already there, like texture decodes.
+struct UpdateThread {
+    Engine *engine = nullptr;
+    float frame_time = 0.0f;
+    float delta_time = 0.0f;
+    bool pending = false; // Whether an update was started and hasn't finished.
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+void run_updates(UpdateThread *update) {
+    std::unique_lock lock(update->mutex);
+
+    while (true) {
+        update->condition.wait(lock, [update] {
+            return update->pending || update->stopping;
+        });
+
+        if (!update->pending) {
+            return;
+        }
+
+        lock.unlock();
+        update->engine->engine_callbacks->update(*update->engine, update->engine->game_object, update->frame_time, update->delta_time);
+        lock.lock();
+
+        update->pending = false;
+        update->condition.notify_all();
+    }
+}
+
 int run(Engine &engine) {
     assert(engine.engine_callbacks);
 
@@ -467,6 +518,10 @@ int run(Engine &engine) {
     float current_frame_time = prev_frame_time;
     float delta_time = current_frame_time - prev_frame_time;
 
+    UpdateThread update;
+    update.engine = &engine;
+    std::thread *update_thread = nullptr;
+
     while (true) {
 #if defined(SUPERLUMINAL)
         char superluminal_event_data[256];
@@ -482,11 +537,41 @@ int run(Engine &engine) {
             }
         }
 
-        // Update
-        if (engine.engine_callbacks && engine.engine_callbacks->update) {
+        // Update. In parallel, the update for this frame runs while the previous frame renders.
+        const bool update_in_parallel = engine.parallel_update && engine.engine_callbacks && engine.engine_callbacks->update;
+
+        if (update_in_parallel) {
+            if (!update_thread) {
+                update_thread = MAKE_NEW(engine.allocator, std::thread, run_updates, &update);
+            }
+
+            {
+                std::scoped_lock lock(update.mutex);
+                update.frame_time = current_frame_time;
+                update.delta_time = delta_time;
+                update.pending = true;
+            }
+
+            update.condition.notify_all();
+
+            render(engine);
+
+            std::unique_lock lock(update.mutex);
+            update.condition.wait(lock, [&update] {
+                return !update.pending;
+            });
+        } else if (engine.engine_callbacks && engine.engine_callbacks->update) {
             engine.engine_callbacks->update(engine, engine.game_object, current_frame_time, delta_time);
         }
 
+        // Swap
+        if (engine.engine_callbacks && engine.engine_callbacks->swap) {
+            engine.engine_callbacks->swap(engine, engine.game_object);
+        }
+
+        // Upload textures the workers have decoded
+        upload_textures(*engine.texture_loader, engine.texture_upload_budget);
+
         if (glfwWindowShouldClose(engine.glfw_window)) {
             if (engine.engine_callbacks && engine.engine_callbacks->on_shutdown) {
                 if (!engine.engine_callbacks->on_shutdown(engine, engine.game_object)) {
@@ -502,7 +587,9 @@ int run(Engine &engine) {
             break;
         }
 
-        render(engine);
+        if (!update_in_parallel) {
+            render(engine);
+        }
 
         engine.window_resized = false;
         process_events(*engine.input);
@@ -531,6 +618,17 @@ int run(Engine &engine) {
 #endif
     }
 
+    if (update_thread) {
+        {
+            std::scoped_lock lock(update.mutex);
+            update.stopping = true;
+        }
+
+        update.condition.notify_all();
+        update_thread->join();
+        MAKE_DELETE(engine.allocator, thread, update_thread);
+    }
+
     return exit_code;
 }
 
@@ -1,6 +1,7 @@
 #include "engine/file.h"
 #include "engine/log.h"
 
+#include <algorithm>
 #include <array.h>
 #include <filesystem>
 #include <memory.h>
@@ -13,7 +14,10 @@
 
 #include <fileapi.h>
 #elif defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 // clang-format on
 
@@ -72,9 +76,21 @@ bool write(foundation::Array<char> &buffer, const char *filename) {
     CloseHandle(file);
     return true;
 #elif defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
-    // TODO: implement
-    log_fatal("Unsupported platform");
-    return false;
+    // Appends, like on Windows.
+    FILE *file = fopen(filename, "ab");
+    if (!file) {
+        log_error("Could not open file %s for writing", filename);
+        return false;
+    }
+
+    if (fwrite(array::begin(buffer), 1, array::size(buffer), file) != array::size(buffer)) {
+        log_error("Error writing to file %s, could not write entire buffer.", filename);
+        fclose(file);
+        return false;
+    }
+
+    fclose(file);
+    return true;
 #else
     log_fatal("Unsupported platform");
     return false;
@@ -143,5 +159,191 @@ bool read(string_stream::Buffer &buffer, const char *filename) {
 #endif
 }
 
+bool info(FileInfo &info, const char *filename) {
+    info = FileInfo();
+
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesEx(filename, GetFileExInfoStandard, &attributes)) {
+        return false;
+    }
+
+    info.size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+    info.modified = ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+    return true;
+#elif defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+    struct stat buf;
+    if (stat(filename, &buf) != 0) {
+        return false;
+    }
+
+#if defined(__APPLE__)
+    const struct timespec modified = buf.st_mtimespec;
+#else
+    const struct timespec modified = buf.st_mtim;
+#endif
+
+    info.size = (uint64_t)buf.st_size;
+    info.modified = (uint64_t)modified.tv_sec * 1000000000ull + (uint64_t)modified.tv_nsec;
+    return true;
+#else
+    log_fatal("Unsupported platform");
+    return false;
+#endif
+}
+
+bool replace(const char *filename, const void *data, uint64_t size) {
+    using namespace string_stream;
+
+    TempAllocator512 ta;
+    Buffer temp_filename(ta);
+    printf(temp_filename, "%s.tmp", filename);
+
+#if defined(_WIN32)
+    HANDLE file = CreateFile(TEXT(c_str(temp_filename)), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == file) {
+        log_error("Could not open file %s for writing: invalid file handle", c_str(temp_filename));
+        return false;
+    }
+
+    // WriteFile takes at most 4 GB at a time.
+    const char *remaining = (const char *)data;
+    uint64_t remaining_size = size;
+    while (remaining_size > 0) {
+        const DWORD chunk = (DWORD)std::min<uint64_t>(remaining_size, 0x40000000);
+        DWORD bytes_written = 0;
+        if (!WriteFile(file, remaining, chunk, &bytes_written, NULL) || bytes_written != chunk) {
+            log_error("Error writing to file %s", c_str(temp_filename));
+            CloseHandle(file);
+            DeleteFile(c_str(temp_filename));
+            return false;
+        }
+
+        remaining += chunk;
+        remaining_size -= chunk;
+    }
+
+    CloseHandle(file);
+
+    if (!MoveFileEx(c_str(temp_filename), filename, MOVEFILE_REPLACE_EXISTING)) {
+        log_error("Could not replace file %s", filename);
+        DeleteFile(c_str(temp_filename));
+        return false;
+    }
+
+    return true;
+#elif defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+    FILE *file = fopen(c_str(temp_filename), "wb");
+    if (!file) {
+        log_error("Could not open file %s for writing", c_str(temp_filename));
+        return false;
+    }
+
+    const bool written = fwrite(data, 1, size, file) == size;
+    if (fclose(file) != 0 || !written) {
+        log_error("Error writing to file %s", c_str(temp_filename));
+        remove(c_str(temp_filename));
+        return false;
+    }
+
+    if (rename(c_str(temp_filename), filename) != 0) {
+        log_error("Could not replace file %s", filename);
+        remove(c_str(temp_filename));
+        return false;
+    }
+
+    return true;
+#else
+    log_fatal("Unsupported platform");
+    return false;
+#endif
+}
+
+bool map(MappedFile &mapped, const char *filename) {
+    mapped = MappedFile();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFile(TEXT(filename), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == file) {
+        log_error("Could not map file %s: invalid file handle", filename);
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        log_error("Could not map file %s: could not get size", filename);
+        CloseHandle(file);
+        return false;
+    }
+
+    if (file_size.QuadPart == 0) {
+        log_error("Could not map file %s: empty file", filename);
+        CloseHandle(file);
+        return false;
+    }
+
+    // The view keeps the file mapped after both handles are closed.
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        log_error("Could not map file %s", filename);
+        return false;
+    }
+
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        log_error("Could not map file %s", filename);
+        return false;
+    }
+
+    mapped.data = (const char *)data;
+    mapped.size = (uint64_t)file_size.QuadPart;
+    return true;
+#elif defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+    int file = open(filename, O_RDONLY);
+    if (file < 0) {
+        log_error("Could not map file %s", filename);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        log_error("Could not map file %s: could not get size", filename);
+        close(file);
+        return false;
+    }
+
+    // The mapping keeps the file open after the descriptor is closed.
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        log_error("Could not map file %s", filename);
+        return false;
+    }
+
+    mapped.data = (const char *)data;
+    mapped.size = (uint64_t)info.st_size;
+    return true;
+#else
+    log_fatal("Unsupported platform");
+    return false;
+#endif
+}
+
+void unmap(MappedFile &mapped) {
+    if (!mapped.data) {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mapped.data);
+#elif defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+    munmap((void *)mapped.data, mapped.size);
+#endif
+
+    mapped = MappedFile();
+}
+
 } // namespace file
 } // namespace engine
@@ -0,0 +1,231 @@
+#include "engine/spatial_grid.h"
+#include "engine/util.inl"
+
+#include <algorithm>
+#include <array.h>
+#include <cassert>
+#include <cmath>
+#include <hash.h>
+
+namespace {
+using namespace engine;
+
+// Items spanning more cells than this go in the oversized list instead.
+const int32_t max_item_cells = 64;
+
+uint64_t cell_key(int32_t x, int32_t y) {
+    return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y;
+}
+
+// Cell coordinates are clamped to this, so huge or non-finite bounds convert to int32_t safely and cell counts can't
+// overflow. Items reaching it span enough cells to go in the oversized list.
+const float max_cell_coord = (float)(1 << 30);
+
+int32_t cell_coord(float coord, float cell_size) {
+    const float cell = floorf(coord / cell_size);
+
+    // NaN fails the comparison and lands in the lowest cell.
+    if (!(cell >= -max_cell_coord)) {
+        return -(int32_t)max_cell_coord;
+    }
+
+    return cell < max_cell_coord ? (int32_t)cell : (int32_t)max_cell_coord;
+}
+
+glm::ivec2 cell_coord(const SpatialGrid &grid, glm::vec2 point) {
+    return {cell_coord(point.x, grid.cell_size), cell_coord(point.y, grid.cell_size)};
+}
+
+// The number of cells in the range [min, max], computed in 64 bits.
+int64_t cell_count(glm::ivec2 min, glm::ivec2 max) {
+    return ((int64_t)max.x - min.x + 1) * ((int64_t)max.y - min.y + 1);
+}
+
+bool overlaps(const GridItem &item, glm::vec2 min, glm::vec2 max) {
+    return item.min.x <= max.x && item.max.x >= min.x && item.min.y <= max.y && item.max.y >= min.y;
+}
+
+void unlink(SpatialGrid &grid, uint64_t id, const GridItem &item) {
+    if (item.oversized) {
+        for (uint32_t i = 0; i < array::size(grid.oversized); ++i) {
+            if (grid.oversized[i] == id) {
+                swap_pop(grid.oversized, i);
+                break;
+            }
+        }
+
+        return;
+    }
+
+    for (int32_t y = item.cell_min.y; y <= item.cell_max.y; ++y) {
+        for (int32_t x = item.cell_min.x; x <= item.cell_max.x; ++x) {
+            const uint64_t key = cell_key(x, y);
+            const Hash<uint64_t>::Entry *entry = multi_hash::find_first(grid.cells, key);
+            while (entry) {
+                if (entry->value == id) {
+                    multi_hash::remove(grid.cells, entry);
+                    break;
+                }
+
+                entry = multi_hash::find_next(grid.cells, entry);
+            }
+        }
+    }
+}
+
+} // namespace
+
+namespace engine {
+
+SpatialGrid::SpatialGrid(Allocator &allocator, float cell_size)
+: allocator(allocator)
+, cell_size(cell_size)
+, cells(allocator)
+, items(allocator)
+, oversized(allocator) {
+    assert(cell_size > 0.0f);
+}
+
+namespace spatial_grid {
+
+void insert(SpatialGrid &grid, uint64_t id, glm::vec2 min, glm::vec2 max) {
+    GridItem item;
+    item.min = min;
+    item.max = max;
+    item.cell_min = cell_coord(grid, min);
+    item.cell_max = cell_coord(grid, max);
+    item.oversized = cell_count(item.cell_min, item.cell_max) > max_item_cells;
+
+    const GridItem *existing = find(grid, id);
+    if (existing) {
+        // Still in the same cells, only the bounds changed.
+        if (existing->oversized == item.oversized && existing->cell_min == item.cell_min && existing->cell_max == item.cell_max) {
+            hash::set(grid.items, id, item);
+            return;
+        }
+
+        unlink(grid, id, *existing);
+    }
+
+    hash::set(grid.items, id, item);
+
+    if (item.oversized) {
+        array::push_back(grid.oversized, id);
+        return;
+    }
+
+    for (int32_t y = item.cell_min.y; y <= item.cell_max.y; ++y) {
+        for (int32_t x = item.cell_min.x; x <= item.cell_max.x; ++x) {
+            multi_hash::insert(grid.cells, cell_key(x, y), id);
+        }
+    }
+}
+
+void remove(SpatialGrid &grid, uint64_t id) {
+    const GridItem *item = find(grid, id);
+    if (!item) {
+        return;
+    }
+
+    unlink(grid, id, *item);
+    hash::remove(grid.items, id);
+}
+
+const GridItem *find(const SpatialGrid &grid, uint64_t id) {
+    const Hash<GridItem>::Entry *entry = multi_hash::find_first(grid.items, id);
+    return entry ? &entry->value : nullptr;
+}
+
+void query(const SpatialGrid &grid, glm::vec2 min, glm::vec2 max, Array<uint64_t> &ids) {
+    const glm::ivec2 query_min = cell_coord(grid, min);
+    const glm::ivec2 query_max = cell_coord(grid, max);
+
+    // Visiting more cells than there are items is slower than checking every item.
+    const int64_t query_cells = cell_count(query_min, query_max);
+    if (query_cells > (int64_t)array::size(grid.items._data)) {
+        for (const Hash<GridItem>::Entry *entry = hash::begin(grid.items); entry != hash::end(grid.items); ++entry) {
+            if (overlaps(entry->value, min, max)) {
+                array::push_back(ids, entry->key);
+            }
+        }
+
+        return;
+    }
+
+    for (int32_t y = query_min.y; y <= query_max.y; ++y) {
+        for (int32_t x = query_min.x; x <= query_max.x; ++x) {
+            const Hash<uint64_t>::Entry *entry = multi_hash::find_first(grid.cells, cell_key(x, y));
+            while (entry) {
+                const GridItem *item = find(grid, entry->value);
+                assert(item);
+
+                // An item is stored in every cell it overlaps. Only report it from the first cell it shares with the query.
+                const bool first_cell = x == std::max(item->cell_min.x, query_min.x) && y == std::max(item->cell_min.y, query_min.y);
+                if (first_cell && overlaps(*item, min, max)) {
+                    array::push_back(ids, entry->value);
+                }
+
+                entry = multi_hash::find_next(grid.cells, entry);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < array::size(grid.oversized); ++i) {
+        const GridItem *item = find(grid, grid.oversized[i]);
+        if (overlaps(*item, min, max)) {
+            array::push_back(ids, grid.oversized[i]);
+        }
+    }
+}
+
+void query_point(const SpatialGrid &grid, glm::vec2 point, Array<uint64_t> &ids) {
+    const glm::ivec2 cell = cell_coord(grid, point);
+
+    // A point is in a single cell, so every item is seen at most once.
+    const Hash<uint64_t>::Entry *entry = multi_hash::find_first(grid.cells, cell_key(cell.x, cell.y));
+    while (entry) {
+        const GridItem *item = find(grid, entry->value);
+        assert(item);
+
+        if (overlaps(*item, point, point)) {
+            array::push_back(ids, entry->value);
+        }
+
+        entry = multi_hash::find_next(grid.cells, entry);
+    }
+
+    for (uint32_t i = 0; i < array::size(grid.oversized); ++i) {
+        const GridItem *item = find(grid, grid.oversized[i]);
+        if (overlaps(*item, point, point)) {
+            array::push_back(ids, grid.oversized[i]);
+        }
+    }
+}
+
+void query_radius(const SpatialGrid &grid, glm::vec2 center, float radius, Array<uint64_t> &ids) {
+    const uint32_t first = array::size(ids);
+    query(grid, center - glm::vec2(radius), center + glm::vec2(radius), ids);
+
+    // Drop the items overlapping the circle's bounds but not the circle.
+    uint32_t count = first;
+    for (uint32_t i = first; i < array::size(ids); ++i) {
+        const GridItem *item = find(grid, ids[i]);
+        const glm::vec2 closest = glm::clamp(center, item->min, item->max);
+        const glm::vec2 delta = center - closest;
+
+        if (delta.x * delta.x + delta.y * delta.y <= radius * radius) {
+            ids[count++] = ids[i];
+        }
+    }
+
+    array::resize(ids, count);
+}
+
+void clear(SpatialGrid &grid) {
+    hash::clear(grid.cells);
+    hash::clear(grid.items);
+    array::clear(grid.oversized);
+}
+
+} // namespace spatial_grid
+} // namespace engine
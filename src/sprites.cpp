@@ -1,9 +1,17 @@
 #include "engine/sprites.h"
 #include "engine/atlas.h"
 #include "engine/engine.h"
+#include "engine/fence_ring.inl"
 #include "engine/log.h"
+#include "engine/mpsc_queue.inl"
+#include "engine/radix_sort.inl"
 #include "engine/shader.h"
+#include "engine/spatial_grid.h"
+#include "engine/sprite_commands.inl"
+#include "engine/sprite_vertices.inl"
+#include "engine/string_pool.h"
 #include "engine/texture.h"
+#include "engine/thread_pool.h"
 #include "engine/util.inl"
 
 #include <GLFW/glfw3.h>
@@ -13,168 +21,1176 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <hash.h>
+#include <inttypes.h>
 #include <memory.h>
 #include <mutex>
+#include <string.h>
 #include <temp_allocator.h>
 #include <algorithm>
+#include <cassert>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/euler_angles.hpp>
 
 namespace {
-const uint64_t max_sprites = 1000000;
+using namespace engine;
+
+// Commits with fewer sprites than this aren't worth spreading across threads.
+const uint32_t parallel_commit_threshold = 16384;
+
+// The smallest number of sprites a commit worker takes at a time.
+const uint32_t parallel_commit_chunk = 4096;
 
 const char *vertex_source = R"(
 #version 410 core
 
-uniform mat4 projection;
-uniform mat4 model;
+uniform mat4 projection;
+uniform mat4 model;
+
+layout (location = 0) in vec3 in_position;
+layout (location = 1) in vec4 in_color;
+layout (location = 2) in vec2 in_texture_coords;
+
+smooth out vec2 uv;
+smooth out vec4 color;
+
+void main() {
+    mat4 mvp = projection * model;
+    gl_Position = mvp * vec4(in_position, 1.0);
+    uv = in_texture_coords;
+    color = in_color;
+}
+)";
+
+const char *fragment_source = R"(
+#version 410 core
+
+uniform sampler2D texture0;
+in vec2 uv;
+in vec4 color;
+
+out vec4 out_color;
+
+void main() {
+    out_color = color * texture(texture0, uv);
+}
+)";
+
+void *insert_gl_fence(void *user_data) {
+    (void)user_data;
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void wait_gl_fence(void *user_data, void *fence) {
+    (void)user_data;
+
+    while (true) {
+        GLenum wait_return = glClientWaitSync((GLsync)fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        if (wait_return == GL_ALREADY_SIGNALED || wait_return == GL_CONDITION_SATISFIED || wait_return == GL_WAIT_FAILED) {
+            return;
+        }
+    }
+}
+
+void remove_gl_fence(void *user_data, void *fence) {
+    (void)user_data;
+    glDeleteSync((GLsync)fence);
+}
+
+const glm::vec2 unit_quad[] = {
+    {0.0f, 0.0f},
+    {1.0f, 1.0f},
+    {0.0f, 1.0f},
+    {1.0f, 0.0f}};
+
+// Returns the world space bounds of a sprite's quad.
+void sprite_bounds(const math::Transform2D &transform, glm::vec2 &min, glm::vec2 &max) {
+    min = max = transform.origin;
+
+    for (int i = 1; i < 4; ++i) {
+        const glm::vec2 corner = math::transform_point(transform, unit_quad[i]);
+        min = glm::min(min, corner);
+        max = glm::max(max, corner);
+    }
+}
+
+// Returns whether a sprite's quad contains a point, by solving for the point in the quad's own coordinates.
+bool quad_contains(const math::Transform2D &transform, glm::vec2 point) {
+    const glm::vec2 u = transform.x_axis;
+    const glm::vec2 v = transform.y_axis;
+    const glm::vec2 p = point - transform.origin;
+
+    const float determinant = u.x * v.y - u.y * v.x;
+    if (determinant == 0.0f) {
+        return false;
+    }
+
+    const float x = (p.x * v.y - p.y * v.x) / determinant;
+    const float y = (u.x * p.y - u.y * p.x) / determinant;
+    return x >= 0.0f && x <= 1.0f && y >= 0.0f && y <= 1.0f;
+}
+
+// Returns the index of a sprite in Sprites::sprites, nullptr if there's no sprite with the id.
+const uint32_t *sprite_index(const engine::Sprites &sprites, uint64_t id) {
+    const foundation::Hash<uint32_t>::Entry *entry = foundation::multi_hash::find_first(sprites.sprite_indices, id);
+    return entry ? &entry->value : nullptr;
+}
+
+// A sprite transform split into the parts the animation channels drive.
+struct SpritePose {
+    glm::vec3 position;
+    float rotation; // Radians around the z axis.
+    glm::vec2 scale;
+};
+
+// Splits a transform into a pose, assuming it has no shear.
+SpritePose decompose(const math::Transform2D &transform) {
+    SpritePose pose;
+    pose.position = {transform.origin, transform.z};
+    pose.rotation = atan2f(transform.x_axis.y, transform.x_axis.x);
+    pose.scale = {glm::length(transform.x_axis), glm::length(transform.y_axis)};
+
+    // A mirrored sprite, keep the flip in the y scale.
+    if (transform.x_axis.x * transform.y_axis.y - transform.x_axis.y * transform.y_axis.x < 0.0f) {
+        pose.scale.y = -pose.scale.y;
+    }
+
+    return pose;
+}
+
+math::Transform2D compose(const SpritePose &pose) {
+    const float c = cosf(pose.rotation);
+    const float s = sinf(pose.rotation);
+
+    math::Transform2D transform;
+    transform.x_axis = {c * pose.scale.x, s * pose.scale.x};
+    transform.y_axis = {-s * pose.scale.y, c * pose.scale.y};
+    transform.origin = {pose.position.x, pose.position.y};
+    transform.z = pose.position.z;
+    return transform;
+}
+
+template <typename T>
+void add_tween(engine::SpriteTweens<T> &tweens, uint64_t animation_id, uint64_t sprite_id, float start_time, float duration, engine::Easing easing, const engine::CubicBezier *curve, T from, T to) {
+    using namespace foundation;
+    array::push_back(tweens.animation_ids, animation_id);
+    array::push_back(tweens.sprite_ids, sprite_id);
+    array::push_back(tweens.start_times, start_time);
+    array::push_back(tweens.durations, duration);
+    array::push_back(tweens.easings, easing);
+    array::push_back(tweens.curves, curve);
+    array::push_back(tweens.from, from);
+    array::push_back(tweens.to, to);
+}
+
+// Removes a tween by moving the last tween into its place.
+template <typename T>
+void remove_tween(engine::SpriteTweens<T> &tweens, uint32_t i) {
+    swap_pop(tweens.animation_ids, i);
+    swap_pop(tweens.sprite_ids, i);
+    swap_pop(tweens.start_times, i);
+    swap_pop(tweens.durations, i);
+    swap_pop(tweens.easings, i);
+    swap_pop(tweens.curves, i);
+    swap_pop(tweens.from, i);
+    swap_pop(tweens.to, i);
+}
+
+// Removes the tracks marked completed by a key count of 0, and the keys they owned, in one sweep. Keeps the order so
+// the tracks' keys stay in track order.
+template <typename T>
+void remove_completed_tracks(engine::SpriteTracks<T> &tracks) {
+    using namespace foundation;
+
+    const uint32_t track_count = array::size(tracks.animation_ids);
+
+    uint32_t kept = 0;
+    uint32_t kept_keys = 0;
+    for (uint32_t i = 0; i < track_count; ++i) {
+        const uint32_t key_count = tracks.key_counts[i];
+        if (key_count == 0) {
+            continue;
+        }
+
+        const uint32_t first_key = tracks.first_keys[i];
+        if (first_key != kept_keys) {
+            memmove(&tracks.keys[kept_keys], &tracks.keys[first_key], sizeof(engine::Keyframe<T>) * key_count);
+        }
+
+        tracks.animation_ids[kept] = tracks.animation_ids[i];
+        tracks.sprite_ids[kept] = tracks.sprite_ids[i];
+        tracks.start_times[kept] = tracks.start_times[i];
+        tracks.first_keys[kept] = kept_keys;
+        tracks.key_counts[kept] = key_count;
+        tracks.cursors[kept] = tracks.cursors[i];
+
+        ++kept;
+        kept_keys += key_count;
+    }
+
+    array::resize(tracks.animation_ids, kept);
+    array::resize(tracks.sprite_ids, kept);
+    array::resize(tracks.start_times, kept);
+    array::resize(tracks.first_keys, kept);
+    array::resize(tracks.key_counts, kept);
+    array::resize(tracks.cursors, kept);
+    array::resize(tracks.keys, kept_keys);
+}
+
+// Returns the record of a completed animation reported by done_sprite_animations.
+engine::SpriteAnimation done_animation(uint64_t animation_id, uint64_t sprite_id, engine::SpriteAnimation::Type type, float start_time, float duration) {
+    engine::SpriteAnimation animation;
+    animation.animation_id = animation_id;
+    animation.sprite_id = sprite_id;
+    animation.type = type;
+    animation.start_time = start_time;
+    animation.duration = duration;
+    animation.completed = true;
+    animation.from_transform = math::Transform2D();
+    animation.to_transform = math::Transform2D();
+    animation.from_color = engine::color::white;
+    animation.to_color = engine::color::white;
+    return animation;
+}
+
+// Fills in the start and end values of a completed animation, per channel type.
+void record_values(engine::SpriteAnimation &animation, glm::vec3 from, glm::vec3 to) {
+    animation.from_transform = compose({from, 0.0f, {1.0f, 1.0f}});
+    animation.to_transform = compose({to, 0.0f, {1.0f, 1.0f}});
+}
+
+void record_values(engine::SpriteAnimation &animation, float from, float to) {
+    animation.from_transform = compose({glm::vec3(0.0f), from, {1.0f, 1.0f}});
+    animation.to_transform = compose({glm::vec3(0.0f), to, {1.0f, 1.0f}});
+}
+
+void record_values(engine::SpriteAnimation &animation, glm::vec2 from, glm::vec2 to) {
+    animation.from_transform = compose({glm::vec3(0.0f), 0.0f, from});
+    animation.to_transform = compose({glm::vec3(0.0f), 0.0f, to});
+}
+
+void record_values(engine::SpriteAnimation &animation, glm::vec4 from, glm::vec4 to) {
+    animation.from_color = from;
+    animation.to_color = to;
+}
+
+// Advances the tweens of a channel to time t and passes each started tween's sprite id and value to apply.
+template <typename T, typename Apply>
+void update_tweens(engine::Sprites &sprites, engine::SpriteTweens<T> &tweens, engine::SpriteAnimation::Type type, float t, Apply apply) {
+    using namespace foundation;
+
+    uint32_t i = 0;
+    while (i < array::size(tweens.animation_ids)) {
+        const float start_time = tweens.start_times[i];
+        if (t < start_time) {
+            ++i;
+            continue;
+        }
+
+        const float duration = tweens.durations[i];
+        const float a = duration > 0.0f ? std::min((t - start_time) / duration, 1.0f) : 1.0f;
+        const T from = tweens.from[i];
+        const T to = tweens.to[i];
+
+        apply(tweens.sprite_ids[i], from + (to - from) * engine::ease(tweens.easings[i], a, tweens.curves[i]));
+
+        if (a < 1.0f) {
+            ++i;
+            continue;
+        }
+
+        engine::SpriteAnimation animation = done_animation(tweens.animation_ids[i], tweens.sprite_ids[i], type, start_time, duration);
+        record_values(animation, from, to);
+        array::push_back(sprites.done_animations, animation);
+
+        remove_tween(tweens, i);
+    }
+}
+
+// Advances the keyframe tracks of a channel to time t and passes each started track's sprite id and value to apply.
+template <typename T, typename Apply>
+void update_tracks(engine::Sprites &sprites, engine::SpriteTracks<T> &tracks, engine::SpriteAnimation::Type type, float t, Apply apply) {
+    using namespace foundation;
+
+    bool completed = false;
+
+    for (uint32_t i = 0; i < array::size(tracks.animation_ids); ++i) {
+        const float start_time = tracks.start_times[i];
+        if (t < start_time) {
+            continue;
+        }
+
+        const engine::Keyframe<T> *keys = &tracks.keys[tracks.first_keys[i]];
+        const uint32_t key_count = tracks.key_counts[i];
+        const float duration = engine::keyframes::duration(keys, key_count);
+
+        apply(tracks.sprite_ids[i], engine::keyframes::evaluate(keys, key_count, t - start_time, tracks.cursors[i]));
+
+        if (t - start_time < duration) {
+            continue;
+        }
+
+        engine::SpriteAnimation animation = done_animation(tracks.animation_ids[i], tracks.sprite_ids[i], type, start_time, duration);
+        record_values(animation, keys[0].value, keys[key_count - 1].value);
+        array::push_back(sprites.done_animations, animation);
+
+        tracks.key_counts[i] = 0;
+        completed = true;
+    }
+
+    if (completed) {
+        remove_completed_tracks(tracks);
+    }
+}
+
+// Removes the flipbooks marked completed by a frame count of 0, and the frames they owned, in one sweep. Keeps the
+// order so the flipbooks' frames stay in flipbook order.
+void remove_completed_flipbooks(engine::SpriteFlipbooks &flipbooks) {
+    using namespace foundation;
+
+    const uint32_t flipbook_count = array::size(flipbooks.animation_ids);
+
+    uint32_t kept = 0;
+    uint32_t kept_frames = 0;
+    for (uint32_t i = 0; i < flipbook_count; ++i) {
+        const uint32_t frame_count = flipbooks.frame_counts[i];
+        if (frame_count == 0) {
+            continue;
+        }
+
+        const uint32_t first_frame = flipbooks.first_frames[i];
+        if (first_frame != kept_frames) {
+            memmove(&flipbooks.frames[kept_frames], &flipbooks.frames[first_frame], sizeof(const engine::AtlasFrame *) * frame_count);
+        }
+
+        flipbooks.animation_ids[kept] = flipbooks.animation_ids[i];
+        flipbooks.sprite_ids[kept] = flipbooks.sprite_ids[i];
+        flipbooks.start_times[kept] = flipbooks.start_times[i];
+        flipbooks.fps[kept] = flipbooks.fps[i];
+        flipbooks.loops[kept] = flipbooks.loops[i];
+        flipbooks.first_frames[kept] = kept_frames;
+        flipbooks.frame_counts[kept] = frame_count;
+        flipbooks.current_frames[kept] = flipbooks.current_frames[i];
+
+        ++kept;
+        kept_frames += frame_count;
+    }
+
+    array::resize(flipbooks.animation_ids, kept);
+    array::resize(flipbooks.sprite_ids, kept);
+    array::resize(flipbooks.start_times, kept);
+    array::resize(flipbooks.fps, kept);
+    array::resize(flipbooks.loops, kept);
+    array::resize(flipbooks.first_frames, kept);
+    array::resize(flipbooks.frame_counts, kept);
+    array::resize(flipbooks.current_frames, kept);
+    array::resize(flipbooks.frames, kept_frames);
+}
+
+// Advances the flipbooks to time t, setting the atlas frame of the sprites whose frame changed.
+void update_flipbooks(engine::Sprites &sprites, float t) {
+    using namespace foundation;
+
+    engine::SpriteFlipbooks &flipbooks = sprites.flipbooks;
+
+    bool any_completed = false;
+
+    for (uint32_t i = 0; i < array::size(flipbooks.animation_ids); ++i) {
+        const float start_time = flipbooks.start_times[i];
+        if (t < start_time) {
+            continue;
+        }
+
+        const uint32_t frame_count = flipbooks.frame_counts[i];
+        const uint32_t elapsed_frames = (uint32_t)((t - start_time) * flipbooks.fps[i]);
+        const bool completed = !flipbooks.loops[i] && elapsed_frames >= frame_count;
+        const uint32_t frame = completed ? frame_count - 1 : elapsed_frames % frame_count;
+
+        if (frame != flipbooks.current_frames[i]) {
+            flipbooks.current_frames[i] = frame;
+
+            const uint32_t *index = sprite_index(sprites, flipbooks.sprite_ids[i]);
+            if (index) {
+                sprites.sprites[*index].atlas_frame = flipbooks.frames[flipbooks.first_frames[i] + frame];
+            }
+        }
+
+        if (!completed) {
+            continue;
+        }
+
+        const float duration = frame_count / flipbooks.fps[i];
+        array::push_back(sprites.done_animations, done_animation(flipbooks.animation_ids[i], flipbooks.sprite_ids[i], engine::SpriteAnimation::Type::Frames, start_time, duration));
+
+        flipbooks.frame_counts[i] = 0;
+        any_completed = true;
+    }
+
+    if (any_completed) {
+        remove_completed_flipbooks(flipbooks);
+    }
+}
+
+// Starts a tween from the value `from` reads off the sprite.
+template <typename T, typename From>
+uint64_t start_tween(engine::Sprites &sprites, engine::SpriteTweens<T> &tweens, uint64_t sprite_id, T to, float duration, float delay, engine::Easing easing, const engine::CubicBezier *curve, From from) {
+    if (easing == engine::Easing::CubicBezier && !curve) {
+        log_error("Sprite animation with a CubicBezier easing has no curve");
+        return 0;
+    }
+
+    std::scoped_lock lock(*sprites.sprites_mutex);
+
+    const uint32_t *index = sprite_index(sprites, sprite_id);
+    if (!index) {
+        return 0;
+    }
+
+    const uint64_t animation_id = ++sprites.animation_id_counter;
+    add_tween(tweens, animation_id, sprite_id, sprites.time + delay, duration, easing, curve, from(sprites.sprites[*index]), to);
+    return animation_id;
+}
+
+template <typename T>
+uint64_t start_track(engine::Sprites &sprites, engine::SpriteTracks<T> &tracks, uint64_t sprite_id, const engine::Keyframe<T> *keys, uint32_t key_count, float delay) {
+    using namespace foundation;
+
+    if (key_count == 0) {
+        return 0;
+    }
+
+    std::scoped_lock lock(*sprites.sprites_mutex);
+
+    if (!sprite_index(sprites, sprite_id)) {
+        return 0;
+    }
+
+    const uint64_t animation_id = ++sprites.animation_id_counter;
+    array::push_back(tracks.animation_ids, animation_id);
+    array::push_back(tracks.sprite_ids, sprite_id);
+    array::push_back(tracks.start_times, sprites.time + delay);
+    array::push_back(tracks.first_keys, array::size(tracks.keys));
+    array::push_back(tracks.key_counts, key_count);
+    array::push_back(tracks.cursors, 0u);
+
+    for (uint32_t i = 0; i < key_count; ++i) {
+        array::push_back(tracks.keys, keys[i]);
+    }
+
+    return animation_id;
+}
+
+// Returns the index of a sprite in the hierarchy, nullptr if it has no parent.
+const uint32_t *hierarchy_index(const SpriteHierarchy &hierarchy, uint64_t id) {
+    const Hash<uint32_t>::Entry *entry = multi_hash::find_first(hierarchy.indices, id);
+    return entry ? &entry->value : nullptr;
+}
+
+// Returns the index of a sprite in the hierarchy, nullptr if it has no parent or its parent was removed. Sprites
+// whose parent was removed act detached right away, and leave the hierarchy on the next commit.
+const uint32_t *attached_index(const Sprites &sprites, uint64_t id) {
+    const uint32_t *index = hierarchy_index(sprites.hierarchy, id);
+    return index && sprite_index(sprites, sprites.hierarchy.parent_ids[*index]) ? index : nullptr;
+}
+
+// Returns the transform animations and transform_sprite work on, relative to the parent if the sprite has one.
+const Transform2D &local_transform(const Sprites &sprites, const Sprite &sprite) {
+    const uint32_t *index = attached_index(sprites, sprite.id);
+    return index ? sprites.hierarchy.local_transforms[*index] : sprite.transform;
+}
+
+// Detaches the sprite at an index of the hierarchy, leaving it where it is in the world.
+void detach_sprite(SpriteHierarchy &hierarchy, uint32_t index) {
+    hash::remove(hierarchy.indices, hierarchy.sprite_ids[index]);
+
+    swap_pop(hierarchy.sprite_ids, index);
+    swap_pop(hierarchy.parent_ids, index);
+    swap_pop(hierarchy.local_transforms, index);
+    swap_pop(hierarchy.dirty, index);
+
+    if (index < array::size(hierarchy.sprite_ids)) {
+        hash::set(hierarchy.indices, hierarchy.sprite_ids[index], index);
+    }
+
+    hierarchy.unordered = true;
+}
+
+// Attaches a sprite to a parent, or detaches it with a parent id of 0. Requires the sprites mutex.
+void attach_sprite(Sprites &sprites, uint64_t id, uint64_t parent_id) {
+    SpriteHierarchy &hierarchy = sprites.hierarchy;
+
+    const uint32_t *sprite = sprite_index(sprites, id);
+    if (!sprite) {
+        return;
+    }
+
+    const uint32_t *index = hierarchy_index(hierarchy, id);
+
+    // Its parent was removed, so it starts over from where it is.
+    if (index && !sprite_index(sprites, hierarchy.parent_ids[*index])) {
+        detach_sprite(hierarchy, *index);
+        index = nullptr;
+    }
+
+    if (parent_id == 0) {
+        if (index) {
+            detach_sprite(hierarchy, *index);
+        }
+        return;
+    }
+
+    if (!sprite_index(sprites, parent_id)) {
+        log_error("Sprites can't parent %" PRIu64 " to missing sprite %" PRIu64, id, parent_id);
+        return;
+    }
+
+    // Walk up from the new parent, reaching the sprite means it would become its own ancestor.
+    for (uint64_t ancestor = parent_id; ancestor != 0;) {
+        if (ancestor == id) {
+            log_error("Sprites can't parent %" PRIu64 " to its descendant %" PRIu64, id, parent_id);
+            return;
+        }
+
+        const uint32_t *ancestor_index = hierarchy_index(hierarchy, ancestor);
+        ancestor = ancestor_index ? hierarchy.parent_ids[*ancestor_index] : 0;
+    }
+
+    if (index) {
+        hierarchy.parent_ids[*index] = parent_id;
+        hierarchy.dirty[*index] = true;
+    } else {
+        hash::set(hierarchy.indices, id, array::size(hierarchy.sprite_ids));
+        array::push_back(hierarchy.sprite_ids, id);
+        array::push_back(hierarchy.parent_ids, parent_id);
+        array::push_back(hierarchy.local_transforms, sprites.sprites[*sprite].transform);
+        array::push_back(hierarchy.dirty, true);
+    }
+
+    hierarchy.unordered = true;
+}
+
+// Orders the hierarchy by depth, so every parent comes before its children. A stable counting sort.
+void order_hierarchy(Sprites &sprites) {
+    SpriteHierarchy &hierarchy = sprites.hierarchy;
+    const uint32_t count = array::size(hierarchy.sprite_ids);
+
+    TempAllocator4096 ta;
+    Array<uint32_t> depths(ta);
+    array::resize(depths, count);
+
+    uint32_t max_depth = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t depth = 0;
+        for (const uint32_t *parent = hierarchy_index(hierarchy, hierarchy.parent_ids[i]); parent; parent = hierarchy_index(hierarchy, hierarchy.parent_ids[*parent])) {
+            ++depth;
+        }
+
+        depths[i] = depth;
+        max_depth = std::max(max_depth, depth);
+    }
+
+    Array<uint32_t> offsets(ta);
+    array::resize(offsets, max_depth + 2);
+    memset(array::begin(offsets), 0, sizeof(uint32_t) * array::size(offsets));
+
+    for (uint32_t i = 0; i < count; ++i) {
+        ++offsets[depths[i] + 1];
+    }
+
+    for (uint32_t depth = 1; depth < array::size(offsets); ++depth) {
+        offsets[depth] += offsets[depth - 1];
+    }
+
+    Array<uint64_t> sprite_ids(sprites.allocator);
+    Array<uint64_t> parent_ids(sprites.allocator);
+    Array<Transform2D> local_transforms(sprites.allocator);
+    Array<bool> dirty(sprites.allocator);
+    array::resize(sprite_ids, count);
+    array::resize(parent_ids, count);
+    array::resize(local_transforms, count);
+    array::resize(dirty, count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t destination = offsets[depths[i]]++;
+        sprite_ids[destination] = hierarchy.sprite_ids[i];
+        parent_ids[destination] = hierarchy.parent_ids[i];
+        local_transforms[destination] = hierarchy.local_transforms[i];
+        dirty[destination] = hierarchy.dirty[i];
+    }
+
+    swap(hierarchy.sprite_ids, sprite_ids);
+    swap(hierarchy.parent_ids, parent_ids);
+    swap(hierarchy.local_transforms, local_transforms);
+    swap(hierarchy.dirty, dirty);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        hash::set(hierarchy.indices, hierarchy.sprite_ids[i], i);
+    }
+
+    hierarchy.unordered = false;
+}
+
+// Detaches the sprites whose parent was removed, where they are, in one pass that keeps parents before children.
+void detach_orphans(Sprites &sprites) {
+    SpriteHierarchy &hierarchy = sprites.hierarchy;
+    const uint32_t count = array::size(hierarchy.sprite_ids);
+
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!sprite_index(sprites, hierarchy.parent_ids[i])) {
+            hash::remove(hierarchy.indices, hierarchy.sprite_ids[i]);
+            continue;
+        }
+
+        if (kept != i) {
+            hierarchy.sprite_ids[kept] = hierarchy.sprite_ids[i];
+            hierarchy.parent_ids[kept] = hierarchy.parent_ids[i];
+            hierarchy.local_transforms[kept] = hierarchy.local_transforms[i];
+            hierarchy.dirty[kept] = hierarchy.dirty[i];
+            hash::set(hierarchy.indices, hierarchy.sprite_ids[kept], kept);
+        }
+
+        ++kept;
+    }
+
+    array::resize(hierarchy.sprite_ids, kept);
+    array::resize(hierarchy.parent_ids, kept);
+    array::resize(hierarchy.local_transforms, kept);
+    array::resize(hierarchy.dirty, kept);
+}
+
+// Computes the world transforms of the attached sprites whose local transform or parent changed, in one sweep
+// with parents before children. Marks the sprites it moves dirty and appends their indices to `moved`.
+void propagate_transforms(Sprites &sprites, Array<uint32_t> &moved) {
+    SpriteHierarchy &hierarchy = sprites.hierarchy;
+
+    if (hierarchy.unordered) {
+        order_hierarchy(sprites);
+    }
+
+    bool orphans = false;
+
+    for (uint32_t i = 0; i < array::size(hierarchy.sprite_ids); ++i) {
+        const uint32_t index = *sprite_index(sprites, hierarchy.sprite_ids[i]);
+        const uint32_t *parent_index = sprite_index(sprites, hierarchy.parent_ids[i]);
+
+        // The parent was removed, the sprite stays where it is.
+        if (!parent_index) {
+            orphans = true;
+            continue;
+        }
+
+        const Sprite &parent = sprites.sprites[*parent_index];
+
+        if (!hierarchy.dirty[i] && !parent.dirty) {
+            continue;
+        }
+
+        hierarchy.dirty[i] = false;
+
+        Sprite &sprite = sprites.sprites[index];
+        sprite.transform = parent.transform * hierarchy.local_transforms[i];
+
+        if (!sprite.dirty) {
+            sprite.dirty = true;
+            array::push_back(moved, index);
+        }
+
+        glm::vec2 min, max;
+        sprite_bounds(sprite.transform, min, max);
+        spatial_grid::insert(*sprites.grid, sprite.id, min, max);
+    }
+
+    if (orphans) {
+        detach_orphans(sprites);
+    }
+}
+
+// Adds a sprite to the arrays and the grid. Requires the sprites mutex.
+void insert_sprite(Sprites &sprites, const Sprite &sprite) {
+    hash::set(sprites.sprite_indices, sprite.id, array::size(sprites.sprites));
+    array::push_back(sprites.sprites, sprite);
+
+    glm::vec2 min, max;
+    sprite_bounds(sprite.transform, min, max);
+    spatial_grid::insert(*sprites.grid, sprite.id, min, max);
+}
+
+// Removes a sprite from the arrays and the grid. Requires the sprites mutex. Its children stay where they are, and
+// leave the hierarchy on the next commit.
+void erase_sprite(Sprites &sprites, const uint64_t id) {
+    const uint32_t *index = sprite_index(sprites, id);
+    if (!index) {
+        return;
+    }
+
+    // The draw order comes from sorting, not from the array, so the last sprite takes the removed one's place.
+    const uint32_t removed = *index;
+    hash::remove(sprites.sprite_indices, id);
+    spatial_grid::remove(*sprites.grid, id);
+    swap_pop(sprites.sprites, removed);
+
+    if (removed < array::size(sprites.sprites)) {
+        hash::set(sprites.sprite_indices, sprites.sprites[removed].id, removed);
+    }
+
+    const uint32_t *hierarchy_slot = hierarchy_index(sprites.hierarchy, id);
+    if (hierarchy_slot) {
+        detach_sprite(sprites.hierarchy, *hierarchy_slot);
+    }
+}
+
+// Applies a queued command.
+void apply_command(Sprites &sprites, const SpriteCommand &command) {
+    switch (command.type) {
+    case SpriteCommand::Type::Add: {
+        Sprite sprite;
+        sprite.id = command.sprite_id;
+        sprite.atlas_frame = command.atlas_frame;
+        sprite.transform = Transform2D();
+        sprite.color = command.color;
+        sprite.atlas_index = command.atlas_index;
+        sprite.layer = command.layer;
+        insert_sprite(sprites, sprite);
+        break;
+    }
+    case SpriteCommand::Type::Remove:
+        erase_sprite(sprites, command.sprite_id);
+        break;
+    case SpriteCommand::Type::Transform:
+        multi_hash::insert(sprites.transforms, command.sprite_id, command.transform);
+        break;
+    case SpriteCommand::Type::Color: {
+        const uint32_t *index = sprite_index(sprites, command.sprite_id);
+        if (index) {
+            sprites.sprites[*index].color = command.color;
+        }
+        break;
+    }
+    case SpriteCommand::Type::Layer: {
+        const uint32_t *index = sprite_index(sprites, command.sprite_id);
+        if (index) {
+            sprites.sprites[*index].layer = command.layer;
+        }
+        break;
+    }
+    case SpriteCommand::Type::Parent:
+        attach_sprite(sprites, command.sprite_id, command.parent_id);
+        break;
+    }
+}
+
+// Applies the queued commands in the order they were queued. Requires the sprites mutex, which also makes whoever
+// holds it the queue's single consumer.
+void apply_commands(Sprites &sprites) {
+    sprite_commands::drain(*sprites.commands, [&sprites](const SpriteCommand &command) {
+        apply_command(sprites, command);
+    });
+}
+
+// Queues a command without locking. If the queue is full, whoever is producing makes room by applying the queued
+// commands itself, under the mutex.
+void enqueue(Sprites &sprites, const SpriteCommand &command) {
+    while (!mpsc_queue::try_push(sprites.commands->queue, command)) {
+        std::scoped_lock lock(*sprites.sprites_mutex);
+        apply_commands(sprites);
+    }
+}
+
+// Returns a frame of one of the atlases, failing if there's no such atlas or frame. The name is only for the error.
+const AtlasFrame *sprite_frame(const Sprites &sprites, uint16_t atlas_index, NameId id, const char *sprite_name) {
+    if (atlas_index >= array::size(sprites.atlases)) {
+        log_fatal("Sprites has no atlas %u", atlas_index);
+    }
+
+    const AtlasFrame *frame = atlas_frame(*sprites.atlases[atlas_index], id);
+    if (!frame) {
+        if (sprite_name) {
+            log_fatal("Sprites atlas doesn't contain %s", sprite_name);
+        } else {
+            log_fatal("Sprites atlas doesn't contain a frame with id %016" PRIx64, id);
+        }
+    }
+
+    return frame;
+}
+
+// Adds a sprite with a frame found by sprite_frame.
+const Sprite add_sprite_frame(Sprites &sprites, uint16_t atlas_index, const AtlasFrame *frame, glm::vec4 color, uint16_t layer) {
+    std::scoped_lock lock(*sprites.sprites_mutex);
+
+    // Queued commands go first, so they can't undo a change made after them.
+    apply_commands(sprites);
+
+    Sprite sprite;
+    sprite.id = ++sprites.commands->sprite_id_counter;
+    sprite.atlas_frame = frame;
+    sprite.transform = Transform2D();
+    sprite.color = color::pack_rgba8(color);
+    sprite.atlas_index = atlas_index;
+    sprite.layer = layer;
+
+    insert_sprite(sprites, sprite);
+
+    return sprite;
+}
+
+// Queues adding a sprite with a frame found by sprite_frame.
+uint64_t queue_add_sprite_frame(Sprites &sprites, uint16_t atlas_index, const AtlasFrame *frame, glm::vec4 color, uint16_t layer) {
+    SpriteCommand command;
+    command.type = SpriteCommand::Type::Add;
+    command.sprite_id = ++sprites.commands->sprite_id_counter;
+    command.atlas_index = atlas_index;
+    command.atlas_frame = frame;
+    command.color = color::pack_rgba8(color);
+    command.layer = layer;
+    enqueue(sprites, command);
+
+    return command.sprite_id;
+}
+
+void missing_flipbook_frame(const char *name) {
+    log_fatal("Sprites atlas doesn't contain %s", name);
+}
+
+void missing_flipbook_frame(NameId id) {
+    log_fatal("Sprites atlas doesn't contain a frame with id %016" PRIx64, id);
+}
+
+// Starts a flipbook through the frames, named or by id, on the sprite's atlas.
+template <typename Name>
+uint64_t start_flipbook(Sprites &sprites, const uint64_t sprite_id, const Name *frame_names, const uint32_t frame_count, const float fps, const bool loop, const float delay) {
+    if (frame_count == 0 || fps <= 0.0f) {
+        return 0;
+    }
+
+    std::scoped_lock lock(*sprites.sprites_mutex);
+
+    const uint32_t *index = sprite_index(sprites, sprite_id);
+    if (!index) {
+        return 0;
+    }
+
+    // Resolve the names once, so the update doesn't hash them every frame.
+    const Atlas *atlas = sprites.atlases[sprites.sprites[*index].atlas_index];
+    SpriteFlipbooks &flipbooks = sprites.flipbooks;
+    const uint32_t first_frame = array::size(flipbooks.frames);
+
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        const AtlasFrame *frame = atlas_frame(*atlas, frame_names[i]);
+        if (!frame) {
+            missing_flipbook_frame(frame_names[i]);
+        }
+
+        array::push_back(flipbooks.frames, frame);
+    }
+
+    const uint64_t animation_id = ++sprites.animation_id_counter;
+    array::push_back(flipbooks.animation_ids, animation_id);
+    array::push_back(flipbooks.sprite_ids, sprite_id);
+    array::push_back(flipbooks.start_times, sprites.time + delay);
+    array::push_back(flipbooks.fps, fps);
+    array::push_back(flipbooks.loops, loop);
+    array::push_back(flipbooks.first_frames, first_frame);
+    array::push_back(flipbooks.frame_counts, frame_count);
+    array::push_back(flipbooks.current_frames, UINT32_MAX);
+
+    return animation_id;
+}
 
-layout (location = 0) in vec3 in_position;
-layout (location = 1) in vec4 in_color;
-layout (location = 2) in vec2 in_texture_coords;
+// Sorts the sprites in draw_order by layer, depth and atlas, and splits them into batches of one draw call each.
+// Sorts compact (key, index) pairs instead of reading the transforms and moving whole sprites on every comparison.
+// Sprites with equal keys draw in the order they were added: they're put in id order first, ids grow with every
+// added sprite, and the radix sort is stable.
+void sort_sprites(Sprites &sprites) {
+    const uint32_t draw_count = array::size(sprites.draw_order);
+
+    array::resize(sprites.sort_keys, draw_count * 2);
+    array::resize(sprites.sort_indices, draw_count * 2);
+
+    uint64_t *keys = array::begin(sprites.sort_keys);
+    uint32_t *indices = array::begin(sprites.sort_indices);
+
+    // Removals and the grid shuffle the order, sort by id unless it's still in order.
+    bool in_id_order = true;
+    for (uint32_t i = 0; i < draw_count; ++i) {
+        indices[i] = sprites.draw_order[i];
+        keys[i] = sprites.sprites[indices[i]].id;
+        in_id_order = in_id_order && (i == 0 || keys[i - 1] < keys[i]);
+    }
 
-smooth out vec2 uv;
-smooth out vec4 color;
+    if (!in_id_order) {
+        radix_sort::sort(keys, indices, keys + draw_count, indices + draw_count, draw_count);
+    }
 
-void main() {
-    mat4 mvp = projection * model;
-    gl_Position = mvp * vec4(in_position, 1.0);
-    uv = in_texture_coords;
-    color = in_color;
+    for (uint32_t i = 0; i < draw_count; ++i) {
+        const Sprite &sprite = sprites.sprites[indices[i]];
+        keys[i] = sprite_sort_key(sprite.layer, sprite.transform.z, sprite.atlas_index);
+    }
+
+    radix_sort::sort(keys, indices, keys + draw_count, indices + draw_count, draw_count);
+
+    memcpy(array::begin(sprites.draw_order), indices, sizeof(uint32_t) * draw_count);
+
+    array::resize(sprites.batches, draw_count);
+    array::resize(sprites.batches, batch_sprites(keys, draw_count, array::begin(sprites.batches)));
 }
-)";
 
-const char *fragment_source = R"(
-#version 410 core
+// The vertex region a commit writes to, shared by the commit workers.
+struct CommitJob {
+    const Sprites *sprites;
+    PackedVertex *vertex_data;
+};
 
-uniform sampler2D texture0;
-in vec2 uv;
-in vec4 color;
+// Writes the vertices of the draw slots in [begin, end). Each slot owns four vertices so ranges never overlap.
+void write_vertices(void *data, uint32_t begin, uint32_t end) {
+    const CommitJob *job = (const CommitJob *)data;
+    const Sprites &sprites = *job->sprites;
 
-out vec4 out_color;
+    for (uint32_t i = begin; i < end; ++i) {
+        const Sprite &sprite = sprites.sprites[sprites.draw_order[i]];
+        write_sprite_vertices(&job->vertex_data[i * 4], sprite.transform, sprite.atlas_frame->texture_coords, sprite.color);
+    }
+}
 
-void main() {
-    out_color = color * texture(texture0, uv);
+// Hands the last commit to render_sprites.
+void publish(Sprites &sprites) {
+    swap(sprites.batches, sprites.render_batches);
+
+    // render_sprites may run while an update adds atlases, so it only reads the textures published here.
+    array::resize(sprites.render_textures, array::size(sprites.render_batches));
+    for (uint32_t i = 0; i < array::size(sprites.render_batches); ++i) {
+        sprites.render_textures[i] = sprites.atlases[sprites.render_batches[i].atlas]->texture->texture;
+    }
+    sprites.render_region = sprites.committed_region;
+    sprites.committed = false;
 }
-)";
 
-const glm::vec4 unit_quad[] = {
-    {0.0f, 0.0f, 0.0f, 1.0f},
-    {1.0f, 1.0f, 0.0f, 1.0f},
-    {0.0f, 1.0f, 0.0f, 1.0f},
-    {1.0f, 0.0f, 0.0f, 1.0f}};
+// Applies the queued commands and pending transforms, then sorts and writes the vertices of the sprites overlapping the view, or of every
+// sprite if there's no view.
+void commit(Sprites &sprites, const glm::vec2 *view_min, const glm::vec2 *view_max) {
+    std::scoped_lock lock(*sprites.sprites_mutex);
+
+    apply_commands(sprites);
+
+    TempAllocator1024 ta;
+    Array<Transform2D> transform_updates(ta);
+    Array<uint32_t> moved(ta); // The sprites whose world transform changed.
+
+    // Only visit the sprites with pending transforms, once each.
+    for (const Hash<Transform2D>::Entry *entry = hash::begin(sprites.transforms); entry != hash::end(sprites.transforms); ++entry) {
+        if (multi_hash::find_first(sprites.transforms, entry->key) != entry) {
+            continue;
+        }
+
+        const uint32_t *index = sprite_index(sprites, entry->key);
+        if (!index) {
+            continue;
+        }
+
+        Sprite *sprite = &sprites.sprites[*index];
+
+        multi_hash::get(sprites.transforms, entry->key, transform_updates);
+
+        // Apply cummulated transform matrices
+        Transform2D sprite_transform = sprite->transform;
+        for (Transform2D *transform_update = array::begin(transform_updates); transform_update != array::end(transform_updates); ++transform_update) {
+            if (transform_update == array::begin(transform_updates)) {
+                sprite_transform = *transform_update;
+            } else {
+                sprite_transform = sprite_transform * *transform_update;
+            }
+        }
+
+        array::clear(transform_updates);
+
+        // Attached sprites are transformed relative to their parent, propagate_transforms computes where they end up.
+        const uint32_t *hierarchy_slot = attached_index(sprites, sprite->id);
+        if (hierarchy_slot) {
+            sprites.hierarchy.local_transforms[*hierarchy_slot] = sprite_transform;
+            sprites.hierarchy.dirty[*hierarchy_slot] = true;
+            continue;
+        }
+
+        sprite->transform = sprite_transform;
+
+        if (!sprite->dirty) {
+            sprite->dirty = true;
+            array::push_back(moved, *index);
+        }
+
+        glm::vec2 min, max;
+        sprite_bounds(sprite->transform, min, max);
+        spatial_grid::insert(*sprites.grid, sprite->id, min, max);
+    }
+
+    hash::clear(sprites.transforms);
+
+    propagate_transforms(sprites, moved);
+
+    for (const uint32_t *index = array::begin(moved); index != array::end(moved); ++index) {
+        sprites.sprites[*index].dirty = false;
+    }
+
+    array::clear(sprites.draw_order);
+
+    if (view_min && view_max) {
+        array::clear(sprites.visible_ids);
+        spatial_grid::query(*sprites.grid, *view_min, *view_max, sprites.visible_ids);
+
+        array::reserve(sprites.draw_order, array::size(sprites.visible_ids));
+        for (const uint64_t *id = array::begin(sprites.visible_ids); id != array::end(sprites.visible_ids); ++id) {
+            array::push_back(sprites.draw_order, *sprite_index(sprites, *id));
+        }
+    } else {
+        const uint32_t sprite_count = array::size(sprites.sprites);
+        array::resize(sprites.draw_order, sprite_count);
+        for (uint32_t i = 0; i < sprite_count; ++i) {
+            sprites.draw_order[i] = i;
+        }
+    }
+
+    uint32_t draw_count = array::size(sprites.draw_order);
+
+    // Single buffered commits grow the buffers and acquire regions, which only the GL thread may do.
+    assert(sprites.double_buffered || glfwGetCurrentContext());
+
+    if (draw_count > sprites.capacity) {
+        if (sprites.double_buffered) {
+            sprites.requested_capacity = std::max(draw_count, sprites.capacity * 2);
+        } else {
+            reserve_sprites(sprites, std::max(draw_count, sprites.capacity * 2));
+        }
+    }
+
+    sort_sprites(sprites);
+
+    // Double buffered commits may run off the GL thread and can't grow the buffers, draw what fits until the next swap.
+    if (draw_count > sprites.capacity) {
+        draw_count = sprites.capacity;
+        array::resize(sprites.draw_order, draw_count);
+
+        while (!array::empty(sprites.batches) && array::back(sprites.batches).first >= draw_count) {
+            array::pop_back(sprites.batches);
+        }
+
+        if (!array::empty(sprites.batches)) {
+            SpriteBatch &last = array::back(sprites.batches);
+            last.count = std::min(last.count, draw_count - last.first);
+        }
+    }
+
+    // Write into the next region of the ring, the GPU may still be reading the previous ones. When double buffered
+    // the region was acquired by the last swap, on the GL thread.
+    const uint32_t region = sprites.double_buffered ? sprites.write_region : fence_ring::acquire(*sprites.fences);
+    PackedVertex *vertex_data = sprites.vertex_data + (size_t)region * sprites.capacity * 4;
+
+    CommitJob job;
+    job.sprites = &sprites;
+    job.vertex_data = vertex_data;
+
+    if (sprites.thread_pool && draw_count >= parallel_commit_threshold) {
+        parallel_for(*sprites.thread_pool, draw_count, parallel_commit_chunk, write_vertices, &job);
+    } else {
+        write_vertices(&job, 0, draw_count);
+    }
+
+    sprites.committed_region = region;
+    sprites.committed = true;
+
+    if (!sprites.double_buffered) {
+        publish(sprites);
+    }
+}
 
 } // namespace
 
 namespace engine {
 
-Sprites::Sprites(Allocator &allocator)
+Sprites::Sprites(Allocator &allocator, uint32_t capacity)
 : allocator(allocator)
 , atlas(nullptr)
+, atlases(allocator)
 , shader(nullptr)
 , vertex_data(nullptr)
+, capacity(0)
+, fences(nullptr)
+, thread_pool(nullptr)
+, committed_region(0)
+, render_region(0)
+, write_region(0)
+, requested_capacity(0)
+, double_buffered(false)
+, committed(false)
 , vbo(0)
 , vao(0)
 , ebo(0)
 , time(0)
-, sprite_id_counter(0)
 , animation_id_counter(0)
 , sprites_mutex(nullptr)
+, commands(nullptr)
 , sprites(allocator)
-, animations(allocator)
+, sprite_indices(allocator)
+, grid(nullptr)
+, hierarchy(allocator)
+, position_tweens(allocator)
+, rotation_tweens(allocator)
+, scale_tweens(allocator)
+, color_tweens(allocator)
+, position_tracks(allocator)
+, rotation_tracks(allocator)
+, scale_tracks(allocator)
+, color_tracks(allocator)
+, flipbooks(allocator)
 , done_animations(allocator)
-, transforms(allocator) {
+, transforms(allocator)
+, sort_keys(allocator)
+, sort_indices(allocator)
+, visible_ids(allocator)
+, draw_order(allocator)
+, batches(allocator)
+, render_batches(allocator)
+, render_textures(allocator) {
     shader = MAKE_NEW(allocator, Shader, nullptr, vertex_source, fragment_source, "Sprites");
     sprites_mutex = MAKE_NEW(allocator, std::mutex);
+    commands = MAKE_NEW(allocator, SpriteCommands);
+    grid = MAKE_NEW(allocator, SpatialGrid, allocator);
 
-    const size_t vertex_count = 4 * max_sprites;
-    const size_t vertex_data_size = sizeof(Vertex) * vertex_count;
-
-    size_t index_count = 6 * max_sprites;
-    GLuint *index_data = (GLuint *)allocator.allocate(sizeof(GLuint) * (uint32_t)index_count);
+    fences = MAKE_NEW(allocator, FenceRing);
+    fences->ops.insert = insert_gl_fence;
+    fences->ops.wait = wait_gl_fence;
+    fences->ops.remove = remove_gl_fence;
 
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    glGenBuffers(1, &vbo);
     glGenBuffers(1, &ebo);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    //    glBufferData(GL_ARRAY_BUFFER, vertex_data_size, vertex_data, GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
-
-    // position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)0);
-
-    // color
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, color));
-
-    // texture_coords
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, texture_coords));
-
-    // Immutable data storage
-    {
-        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
-        glBufferStorage(GL_ARRAY_BUFFER, vertex_data_size, 0, flags);
-        vertex_data = (Vertex *)glMapBufferRange(GL_ARRAY_BUFFER, 0, vertex_data_size, flags);
-
-        for (uint64_t i = 0; i < max_sprites; ++i) {
-            // position
-            {
-                // Copy unit quad into vertex data for this sprite
-                for (int ii = 0; ii < 4; ++ii) {
-                    vertex_data[i * 4 + ii].position = {unit_quad[ii].x, unit_quad[ii].y, unit_quad[ii].z};
-                }
-            }
-
-            // color
-            {
-                vertex_data[i * 4 + 0].color = {1.0f, 1.0f, 1.0f, 1.0f};
-                vertex_data[i * 4 + 1].color = {1.0f, 1.0f, 1.0f, 1.0f};
-                vertex_data[i * 4 + 2].color = {1.0f, 1.0f, 1.0f, 1.0f};
-                vertex_data[i * 4 + 3].color = {1.0f, 1.0f, 1.0f, 1.0f};
-            }
-
-            // texture_coords
-            {
-                vertex_data[i * 4 + 0].texture_coords = {0.0, 0.0};
-                vertex_data[i * 4 + 1].texture_coords = {0.0, 0.0};
-                vertex_data[i * 4 + 2].texture_coords = {0.0, 0.0};
-                vertex_data[i * 4 + 3].texture_coords = {0.0, 0.0};
+    reserve_sprites(*this, capacity);
+}
 
-                index_data[i * 6 + 0] = (GLuint)i * 4 + 0;
-                index_data[i * 6 + 1] = (GLuint)i * 4 + 1;
-                index_data[i * 6 + 2] = (GLuint)i * 4 + 2;
+Sprites::Sprites(Allocator &allocator, const Engine &engine, uint32_t capacity)
+: Sprites(allocator, capacity) {
+    thread_pool = engine.thread_pool;
 
-                index_data[i * 6 + 3] = (GLuint)i * 4 + 0;
-                index_data[i * 6 + 4] = (GLuint)i * 4 + 3;
-                index_data[i * 6 + 5] = (GLuint)i * 4 + 1;
-            }
-        }
+    // The first update may run on the update thread before the first swap, so its commits must already leave the GL
+    // work to swaps. Constructed on the GL thread, the first region can be acquired here.
+    if (engine.parallel_update) {
+        double_buffered = true;
+        write_region = fence_ring::acquire(*fences);
     }
-
-    // Element index array
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(GLuint), index_data, GL_STATIC_DRAW);
-
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
-    glDisableVertexAttribArray(2);
-
-    allocator.deallocate(index_data);
 }
 
 Sprites::~Sprites() {
-    MAKE_DELETE(allocator, Atlas, atlas);
+    for (uint32_t i = 0; i < array::size(atlases); ++i) {
+        MAKE_DELETE(allocator, Atlas, atlases[i]);
+    }
+
     MAKE_DELETE(allocator, Shader, shader);
     MAKE_DELETE(allocator, mutex, sprites_mutex);
+    MAKE_DELETE(allocator, SpriteCommands, commands);
+    MAKE_DELETE(allocator, SpatialGrid, grid);
+
+    fence_ring::clear(*fences);
+    MAKE_DELETE(allocator, FenceRing, fences);
 
     if (vbo) {
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
@@ -191,272 +1207,402 @@ Sprites::~Sprites() {
     }
 }
 
-void init_sprites(Sprites &sprites, const char *atlas_filename) {
-    sprites.atlas = MAKE_NEW(sprites.allocator, Atlas, sprites.allocator, atlas_filename);
+void init_sprites(Sprites &sprites, const char *atlas_filename, const TextureOptions &texture_options) {
+    add_sprites_atlas(sprites, atlas_filename, texture_options);
 }
 
-const Sprite add_sprite(Sprites &sprites, const char *sprite_name, glm::vec4 color) {
+uint16_t add_sprites_atlas(Sprites &sprites, const char *atlas_filename, const TextureOptions &texture_options) {
+    if (!glfwGetCurrentContext()) {
+        log_fatal("Sprites can only load %s on the thread owning the GL context", atlas_filename);
+    }
+
+    return add_sprites_atlas(sprites, MAKE_NEW(sprites.allocator, Atlas, sprites.allocator, atlas_filename, texture_options));
+}
+
+uint16_t add_sprites_atlas(Sprites &sprites, Atlas *atlas) {
     std::scoped_lock lock(*sprites.sprites_mutex);
 
-    if (array::size(sprites.sprites) > max_sprites) {
-        log_fatal("Sprites already at max size");
+    if (array::size(sprites.atlases) > UINT16_MAX) {
+        log_fatal("Sprites has too many atlases");
     }
 
-    const AtlasFrame *frame = atlas_frame(*sprites.atlas, sprite_name);
-    if (!frame) {
-        log_fatal("Sprites atlas doesn't contain %s", sprite_name);
+    array::push_back(sprites.atlases, atlas);
+
+    if (!sprites.atlas) {
+        sprites.atlas = atlas;
     }
 
-    Sprite sprite;
-    sprite.id = ++sprites.sprite_id_counter;
-    sprite.atlas_frame = frame;
-    sprite.transform = glm::mat4(1.0f);
-    sprite.color = color;
+    return (uint16_t)(array::size(sprites.atlases) - 1);
+}
 
-    array::push_back(sprites.sprites, sprite);
-    
-    return sprite;
+void reserve_sprites(Sprites &sprites, uint32_t capacity) {
+    if (sprites.vbo && capacity <= sprites.capacity) {
+        return;
+    }
+
+    capacity = std::max(capacity, 1u);
+
+    const size_t vertex_data_size = sizeof(PackedVertex) * 4 * (size_t)capacity * sprites.fences->region_count;
+    const size_t index_count = 6 * (size_t)capacity;
+
+    GLuint *index_data = (GLuint *)sprites.allocator.allocate((uint32_t)(sizeof(GLuint) * index_count));
+    for (uint32_t i = 0; i < capacity; ++i) {
+        index_data[i * 6 + 0] = i * 4 + 0;
+        index_data[i * 6 + 1] = i * 4 + 1;
+        index_data[i * 6 + 2] = i * 4 + 2;
+
+        index_data[i * 6 + 3] = i * 4 + 0;
+        index_data[i * 6 + 4] = i * 4 + 3;
+        index_data[i * 6 + 5] = i * 4 + 1;
+    }
+
+    glBindVertexArray(sprites.vao);
+
+    // Immutable storage can't be resized, so replace the vertex buffer.
+    const GLuint previous_vbo = sprites.vbo;
+    const uint32_t previous_capacity = sprites.capacity;
+
+    if (previous_vbo) {
+        fence_ring::clear(*sprites.fences);
+    }
+
+    glGenBuffers(1, &sprites.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, sprites.vbo);
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, vertex_data_size, 0, flags);
+    sprites.vertex_data = (PackedVertex *)glMapBufferRange(GL_ARRAY_BUFFER, 0, vertex_data_size, flags);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    // position
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (const GLvoid *)0);
+
+    // color, normalized RGBA8
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex), (const GLvoid *)offsetof(PackedVertex, color));
+
+    // texture_coords, normalized 16 bit
+    glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (const GLvoid *)offsetof(PackedVertex, texture_coords));
+
+    // Carry over the vertices render_sprites draws, the next commit rewrites the rest.
+    if (previous_vbo) {
+        const uint32_t render_count = array::empty(sprites.render_batches) ? 0 : array::back(sprites.render_batches).first + array::back(sprites.render_batches).count;
+
+        glBindBuffer(GL_COPY_READ_BUFFER, previous_vbo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, sprites.vbo);
+
+        if (render_count > 0) {
+            const GLintptr read_offset = sizeof(PackedVertex) * 4 * (GLintptr)sprites.render_region * previous_capacity;
+            const GLintptr write_offset = sizeof(PackedVertex) * 4 * (GLintptr)sprites.render_region * capacity;
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, read_offset, write_offset, sizeof(PackedVertex) * 4 * (GLsizeiptr)render_count);
+        }
+
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &previous_vbo);
+    }
+
+    // Element index array
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sprites.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(GLuint), index_data, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    sprites.allocator.deallocate(index_data);
+    sprites.capacity = capacity;
+
+    log_debug("Sprites capacity %u, vertex buffer %.1f MB, index buffer %.1f MB", capacity, vertex_data_size / (1024.0 * 1024.0), index_count * sizeof(GLuint) / (1024.0 * 1024.0));
+}
+
+const Sprite add_sprite(Sprites &sprites, const char *sprite_name, glm::vec4 color) {
+    return add_sprite(sprites, 0, sprite_name, color);
+}
+
+const Sprite add_sprite(Sprites &sprites, uint16_t atlas_index, const char *sprite_name, glm::vec4 color, uint16_t layer) {
+    const NameId id = string_pool::name_id(sprite_name, (uint32_t)strlen(sprite_name));
+    return add_sprite_frame(sprites, atlas_index, sprite_frame(sprites, atlas_index, id, sprite_name), color, layer);
+}
+
+const Sprite add_sprite(Sprites &sprites, uint16_t atlas_index, NameId sprite_name, glm::vec4 color, uint16_t layer) {
+    return add_sprite_frame(sprites, atlas_index, sprite_frame(sprites, atlas_index, sprite_name, nullptr), color, layer);
 }
 
 void remove_sprite(Sprites &sprites, const uint64_t id) {
     std::scoped_lock lock(*sprites.sprites_mutex);
 
-    for (uint32_t i = 0; i < array::size(sprites.sprites); ++i) {
-        const Sprite *sprite = &sprites.sprites[i];
-        if (sprite->id == id) {
-            shift_pop(sprites.sprites, i);
-            break;
-        }
-    }
+    // A sprite queued for adding is added first, or it would come back on commit.
+    apply_commands(sprites);
+    erase_sprite(sprites, id);
+}
+
+uint64_t queue_add_sprite(Sprites &sprites, uint16_t atlas_index, const char *sprite_name, glm::vec4 color, uint16_t layer) {
+    const NameId id = string_pool::name_id(sprite_name, (uint32_t)strlen(sprite_name));
+    return queue_add_sprite_frame(sprites, atlas_index, sprite_frame(sprites, atlas_index, id, sprite_name), color, layer);
+}
+
+uint64_t queue_add_sprite(Sprites &sprites, uint16_t atlas_index, NameId sprite_name, glm::vec4 color, uint16_t layer) {
+    return queue_add_sprite_frame(sprites, atlas_index, sprite_frame(sprites, atlas_index, sprite_name, nullptr), color, layer);
+}
+
+void queue_remove_sprite(Sprites &sprites, const uint64_t id) {
+    SpriteCommand command;
+    command.type = SpriteCommand::Type::Remove;
+    command.sprite_id = id;
+    enqueue(sprites, command);
 }
 
 const Sprite *get_sprite(const Sprites &sprites, const uint64_t id) {
     std::scoped_lock lock(*sprites.sprites_mutex);
-    for (const Sprite *iter = array::begin(sprites.sprites); iter != array::end(sprites.sprites); ++iter) {
-        if (iter->id == id) {
-            return iter;
-        }
-    }
+    const uint32_t *index = sprite_index(sprites, id);
+    return index ? &sprites.sprites[*index] : nullptr;
+}
 
-    return nullptr;
+void transform_sprite(Sprites &sprites, const uint64_t id, const Transform2D &transform) {
+    SpriteCommand command;
+    command.type = SpriteCommand::Type::Transform;
+    command.sprite_id = id;
+    command.transform = transform;
+    enqueue(sprites, command);
 }
 
 void transform_sprite(Sprites &sprites, const uint64_t id, const glm::mat4 transform) {
-    std::scoped_lock lock(*sprites.sprites_mutex);
-    multi_hash::insert(sprites.transforms, id, transform);
+    transform_sprite(sprites, id, to_transform2d(transform));
 }
 
 void color_sprite(Sprites &sprites, const uint64_t id, const glm::vec4 color) {
+    SpriteCommand command;
+    command.type = SpriteCommand::Type::Color;
+    command.sprite_id = id;
+    command.color = color::pack_rgba8(color);
+    enqueue(sprites, command);
+}
+
+void parent_sprite(Sprites &sprites, const uint64_t id, const uint64_t parent_id) {
+    SpriteCommand command;
+    command.type = SpriteCommand::Type::Parent;
+    command.sprite_id = id;
+    command.parent_id = parent_id;
+    enqueue(sprites, command);
+}
+
+void layer_sprite(Sprites &sprites, const uint64_t id, const uint16_t layer) {
+    SpriteCommand command;
+    command.type = SpriteCommand::Type::Layer;
+    command.sprite_id = id;
+    command.layer = layer;
+    enqueue(sprites, command);
+}
+
+void sprites_at_point(const Sprites &sprites, glm::vec2 point, Array<uint64_t> &ids) {
     std::scoped_lock lock(*sprites.sprites_mutex);
 
-    for (engine::Sprite *iter = array::begin(sprites.sprites); iter != array::end(sprites.sprites); ++iter) {
-        if (iter->id == id) {
-            iter->color = color;
-            break;
+    const uint32_t first = array::size(ids);
+    spatial_grid::query_point(*sprites.grid, point, ids);
+
+    // The grid only knows the bounds, drop the sprites whose rotated quads don't contain the point.
+    uint32_t count = first;
+    for (uint32_t i = first; i < array::size(ids); ++i) {
+        const Sprite &sprite = sprites.sprites[*sprite_index(sprites, ids[i])];
+        if (quad_contains(sprite.transform, point)) {
+            ids[count++] = ids[i];
         }
     }
+
+    array::resize(ids, count);
+}
+
+void sprites_in_rect(const Sprites &sprites, glm::vec2 min, glm::vec2 max, Array<uint64_t> &ids) {
+    std::scoped_lock lock(*sprites.sprites_mutex);
+    spatial_grid::query(*sprites.grid, min, max, ids);
+}
+
+void sprites_in_radius(const Sprites &sprites, glm::vec2 center, float radius, Array<uint64_t> &ids) {
+    std::scoped_lock lock(*sprites.sprites_mutex);
+    spatial_grid::query_radius(*sprites.grid, center, radius, ids);
 }
 
 const Array<SpriteAnimation> &done_sprite_animations(Sprites &sprites) {
     return sprites.done_animations;
 }
 
-uint64_t animate_sprite_position(Sprites &sprites, const uint64_t sprite_id, const glm::vec3 to_position, const float duration, const float delay) {
-    const Sprite *sprite = get_sprite(sprites, sprite_id);
-    if (!sprite) {
-        return 0;
-    }
+uint64_t animate_sprite_position(Sprites &sprites, const uint64_t sprite_id, const glm::vec3 to_position, const float duration, const float delay, const Easing easing, const CubicBezier *curve) {
+    return start_tween(sprites, sprites.position_tweens, sprite_id, to_position, duration, delay, easing, curve, [&sprites](const Sprite &sprite) {
+        return decompose(local_transform(sprites, sprite)).position;
+    });
+}
 
-    SpriteAnimation animation;
-    animation.animation_id = ++sprites.animation_id_counter;
-    animation.sprite_id = sprite_id;
-    animation.type = SpriteAnimation::Type::Position;
-    animation.start_time = sprites.time + delay;
-    animation.duration = duration;
-    animation.completed = false;
-    animation.from_transform = sprite->transform;
+uint64_t animate_sprite_rotation(Sprites &sprites, const uint64_t sprite_id, const float to_rotation, const float duration, const float delay, const Easing easing, const CubicBezier *curve) {
+    return start_tween(sprites, sprites.rotation_tweens, sprite_id, to_rotation, duration, delay, easing, curve, [&sprites](const Sprite &sprite) {
+        return decompose(local_transform(sprites, sprite)).rotation;
+    });
+}
 
-    {
-        glm::vec3 to_position_vec3 = glm::vec3(to_position.x, to_position.y, to_position.z);
-        glm::mat4 from_transform_mat4 = animation.from_transform;
-        glm::vec3 from_position_vec3 = from_transform_mat4[3];
-        glm::mat4 delta(1.0f);
-        delta = glm::translate(delta, to_position_vec3 - from_position_vec3);
-        animation.to_transform = delta * from_transform_mat4;
-    }
+uint64_t animate_sprite_scale(Sprites &sprites, const uint64_t sprite_id, const glm::vec2 to_scale, const float duration, const float delay, const Easing easing, const CubicBezier *curve) {
+    return start_tween(sprites, sprites.scale_tweens, sprite_id, to_scale, duration, delay, easing, curve, [&sprites](const Sprite &sprite) {
+        return decompose(local_transform(sprites, sprite)).scale;
+    });
+}
 
-    array::push_back(sprites.animations, animation);
+uint64_t animate_sprite_color(Sprites &sprites, const uint64_t sprite_id, const glm::vec4 to_color, const float duration, const float delay, const Easing easing, const CubicBezier *curve) {
+    return start_tween(sprites, sprites.color_tweens, sprite_id, to_color, duration, delay, easing, curve, [](const Sprite &sprite) {
+        return color::unpack_rgba8(sprite.color);
+    });
+}
 
-    return animation.animation_id;
+uint64_t play_sprite_position_track(Sprites &sprites, const uint64_t sprite_id, const Keyframe<glm::vec3> *keys, const uint32_t key_count, const float delay) {
+    return start_track(sprites, sprites.position_tracks, sprite_id, keys, key_count, delay);
 }
 
-uint64_t animate_sprite_color(Sprites &sprites, const uint64_t sprite_id, const glm::vec4 to_color, const float duration, const float delay) {
-    const Sprite *sprite = get_sprite(sprites, sprite_id);
-    if (!sprite) {
-        return 0;
-    }
+uint64_t play_sprite_rotation_track(Sprites &sprites, const uint64_t sprite_id, const Keyframe<float> *keys, const uint32_t key_count, const float delay) {
+    return start_track(sprites, sprites.rotation_tracks, sprite_id, keys, key_count, delay);
+}
 
-    SpriteAnimation animation;
-    animation.animation_id = ++sprites.animation_id_counter;
-    animation.sprite_id = sprite_id;
-    animation.type = SpriteAnimation::Type::Color;
-    animation.start_time = sprites.time + delay;
-    animation.duration = duration;
-    animation.completed = false;
-    animation.from_color = sprite->color;
-    animation.to_color = to_color;
+uint64_t play_sprite_scale_track(Sprites &sprites, const uint64_t sprite_id, const Keyframe<glm::vec2> *keys, const uint32_t key_count, const float delay) {
+    return start_track(sprites, sprites.scale_tracks, sprite_id, keys, key_count, delay);
+}
+
+uint64_t play_sprite_color_track(Sprites &sprites, const uint64_t sprite_id, const Keyframe<glm::vec4> *keys, const uint32_t key_count, const float delay) {
+    return start_track(sprites, sprites.color_tracks, sprite_id, keys, key_count, delay);
+}
 
-    array::push_back(sprites.animations, animation);
+uint64_t animate_sprite_frames(Sprites &sprites, const uint64_t sprite_id, const char **frame_names, const uint32_t frame_count, const float fps, const bool loop, const float delay) {
+    return start_flipbook(sprites, sprite_id, frame_names, frame_count, fps, loop, delay);
+}
 
-    return animation.animation_id;
+uint64_t animate_sprite_frames(Sprites &sprites, const uint64_t sprite_id, const NameId *frame_names, const uint32_t frame_count, const float fps, const bool loop, const float delay) {
+    return start_flipbook(sprites, sprite_id, frame_names, frame_count, fps, loop, delay);
 }
 
 void update_sprites(Sprites &sprites, float t, float dt) {
     (void)dt;
-    sprites.time = t;
 
-    bool dirty = false;
+    // Animations are applied in one batch under a single lock, rather than locking once per animation.
+    std::scoped_lock lock(*sprites.sprites_mutex);
+
+    sprites.time = t;
 
     array::clear(sprites.done_animations);
 
-    for (SpriteAnimation *animation = array::begin(sprites.animations); animation != array::end(sprites.animations); ++animation) {
-        if (t < animation->start_time) {
-            continue;
-        }
+    // The position, rotation and scale channels of a sprite all drive its transform. They're gathered into one pose
+    // per sprite and queued as a single transform.
+    TempAllocator4096 ta;
+    Hash<SpritePose> poses(ta);
 
-        bool completed = false;
-        float a = (t - animation->start_time) / animation->duration;
-        if (a > 1.0f) {
-            a = 1.0f;
-            completed = true;
+    auto pose = [&sprites, &poses](uint64_t sprite_id, SpritePose &sprite_pose) {
+        const Hash<SpritePose>::Entry *entry = multi_hash::find_first(poses, sprite_id);
+        if (entry) {
+            sprite_pose = entry->value;
+            return true;
         }
 
-        switch (animation->type) {
-        case SpriteAnimation::Type::Position: {
-            const glm::vec3 from_pos = animation->from_transform[3];
-            const glm::vec3 to_pos = animation->to_transform[3];
-            const glm::vec3 mixed_pos = glm::mix(from_pos, to_pos, a);
+        const uint32_t *index = sprite_index(sprites, sprite_id);
+        if (!index) {
+            return false;
+        }
 
-            glm::mat4 delta(1.0f);
-            delta = glm::translate(delta, -from_pos);
-            delta = glm::translate(delta, mixed_pos);
+        sprite_pose = decompose(local_transform(sprites, sprites.sprites[*index]));
+        return true;
+    };
 
-            const glm::mat4 mixed_transform = delta * animation->from_transform;
-            transform_sprite(sprites, animation->sprite_id, mixed_transform);
-            break;
-        }
-        case SpriteAnimation::Type::Rotation: {
-            log_fatal("Sprite rotation animation not implemented");
-            // TODO: Implement
-            break;
-        }
-        case SpriteAnimation::Type::Color: {
-            const glm::vec4 from_color = animation->from_color;
-            const glm::vec4 to_color = animation->to_color;
-            const glm::vec4 mixed_color = math::mix(from_color, to_color, a);
-            color_sprite(sprites, animation->sprite_id, mixed_color);
-        }
+    auto move = [&poses, &pose](uint64_t sprite_id, glm::vec3 position) {
+        SpritePose sprite_pose;
+        if (pose(sprite_id, sprite_pose)) {
+            sprite_pose.position = position;
+            hash::set(poses, sprite_id, sprite_pose);
         }
+    };
 
-        if (completed) {
-            animation->completed = true;
-            dirty = true;
+    auto rotate = [&poses, &pose](uint64_t sprite_id, float rotation) {
+        SpritePose sprite_pose;
+        if (pose(sprite_id, sprite_pose)) {
+            sprite_pose.rotation = rotation;
+            hash::set(poses, sprite_id, sprite_pose);
         }
-    }
-
-    if (dirty) {
-        Array<SpriteAnimation> animations(sprites.allocator);
-        array::reserve(animations, array::size(sprites.animations));
+    };
 
-        for (SpriteAnimation *animation = array::begin(sprites.animations); animation != array::end(sprites.animations); ++animation) {
-            if (animation->completed) {
-                array::push_back(sprites.done_animations, *animation);
-            } else {
-                array::push_back(animations, *animation);
-            }
+    auto scale = [&poses, &pose](uint64_t sprite_id, glm::vec2 scale) {
+        SpritePose sprite_pose;
+        if (pose(sprite_id, sprite_pose)) {
+            sprite_pose.scale = scale;
+            hash::set(poses, sprite_id, sprite_pose);
         }
+    };
 
-        sprites.animations = animations;
-    }
+    auto paint = [&sprites](uint64_t sprite_id, glm::vec4 color) {
+        const uint32_t *index = sprite_index(sprites, sprite_id);
+        if (index) {
+            sprites.sprites[*index].color = color::pack_rgba8(color);
+        }
+    };
+
+    auto apply = [&sprites](const SpriteCommand &command) {
+        apply_command(sprites, command);
+    };
+
+    // Changes queued so far apply first, so running animations win over them.
+    sprite_commands::update(*sprites.commands, apply, [&]() {
+        update_tweens(sprites, sprites.position_tweens, SpriteAnimation::Type::Position, t, move);
+        update_tracks(sprites, sprites.position_tracks, SpriteAnimation::Type::Position, t, move);
+        update_tweens(sprites, sprites.rotation_tweens, SpriteAnimation::Type::Rotation, t, rotate);
+        update_tracks(sprites, sprites.rotation_tracks, SpriteAnimation::Type::Rotation, t, rotate);
+        update_tweens(sprites, sprites.scale_tweens, SpriteAnimation::Type::Scale, t, scale);
+        update_tracks(sprites, sprites.scale_tracks, SpriteAnimation::Type::Scale, t, scale);
+        update_tweens(sprites, sprites.color_tweens, SpriteAnimation::Type::Color, t, paint);
+        update_tracks(sprites, sprites.color_tracks, SpriteAnimation::Type::Color, t, paint);
+        update_flipbooks(sprites, t);
+
+        for (const Hash<SpritePose>::Entry *entry = hash::begin(poses); entry != hash::end(poses); ++entry) {
+            multi_hash::insert(sprites.transforms, entry->key, compose(entry->value));
+        }
+    });
 }
 
-bool sort_fn(const Sprite &lhs, const Sprite &rhs) {
-    glm::vec3 lhs_pos = lhs.transform[3];
-    glm::vec3 rhs_pos = rhs.transform[3];
-    return (lhs_pos.z < rhs_pos.z);
+void commit_sprites(Sprites &sprites) {
+    commit(sprites, nullptr, nullptr);
 }
 
-void commit_sprites(Sprites &sprites) {
-    std::scoped_lock lock(*sprites.sprites_mutex);
+void commit_sprites(Sprites &sprites, const Engine &engine) {
+    // Sprites are drawn scaled by the zoom and render scale, then offset by the camera. See render_sprites.
+    const float scale = engine.camera_zoom * engine.render_scale;
+    const glm::vec2 camera_offset = {(float)engine.camera_offset.x, (float)engine.camera_offset.y};
+    const glm::vec2 window_size = {(float)engine.window_rect.size.x, (float)engine.window_rect.size.y};
 
-    TempAllocator1024 ta;
-    Array<glm::mat4> transform_updates(ta);
+    const glm::vec2 view_min = camera_offset / scale;
+    const glm::vec2 view_max = (camera_offset + window_size) / scale;
 
-    for (engine::Sprite *sprite = array::begin(sprites.sprites); sprite != array::end(sprites.sprites); ++sprite) {
-        multi_hash::get(sprites.transforms, sprite->id, transform_updates);
+    commit(sprites, &view_min, &view_max);
+}
 
-        glm::mat4 sprite_transform = sprite->transform;
+void swap_sprites(Sprites &sprites) {
+    std::scoped_lock lock(*sprites.sprites_mutex);
 
-        if (!array::empty(transform_updates)) {
-            // Apply cummulated transform matrices
-            for (glm::mat4 *transform_update = array::begin(transform_updates); transform_update != array::end(transform_updates); ++transform_update) {
-                if (transform_update == array::begin(transform_updates)) {
-                    sprite_transform = *transform_update;
-                } else {
-                    sprite_transform *= *transform_update;
-                }
-            }
+    const bool first_swap = !sprites.double_buffered;
+    sprites.double_buffered = true;
 
-            sprite->transform = sprite_transform;
-            array::clear(transform_updates);
-        }
+    const bool published = sprites.committed;
+    if (published) {
+        publish(sprites);
     }
-    
-    std::sort(array::begin(sprites.sprites), array::end(sprites.sprites), sort_fn);
-    
-    for (uint32_t i = 0; i < array::size(sprites.sprites); ++i) {
-        const Sprite *sprite = &sprites.sprites[i];
-
-        // position
-        {
-            for (int ii = 0; ii < 4; ++ii) {
-                const glm::vec4 position = sprite->transform * unit_quad[ii];
-                sprites.vertex_data[i * 4 + ii].position = {position.x, position.y, position.z};
-            }
-        }
 
-        // texture coords
-        {
-            const int atlas_width = sprites.atlas->texture->width;
-            const int atlas_height = sprites.atlas->texture->height;
-
-            float texcoord_x = (float)sprite->atlas_frame->rect.origin.x / atlas_width;
-            float texcoord_y = (float)(sprite->atlas_frame->rect.origin.y + sprite->atlas_frame->rect.size.y) / atlas_height;
-            float texcoord_w = (float)sprite->atlas_frame->rect.size.x / atlas_width;
-            float texcoord_h = (float)sprite->atlas_frame->rect.size.y / atlas_height;
+    if (sprites.requested_capacity > sprites.capacity) {
+        reserve_sprites(sprites, sprites.requested_capacity);
+    }
 
-            sprites.vertex_data[i * 4 + 0].texture_coords = {texcoord_x, texcoord_y};
-            sprites.vertex_data[i * 4 + 1].texture_coords = {texcoord_x + texcoord_w, texcoord_y - texcoord_h};
-            sprites.vertex_data[i * 4 + 2].texture_coords = {texcoord_x, texcoord_y - texcoord_h};
-            sprites.vertex_data[i * 4 + 3].texture_coords = {texcoord_x + texcoord_w, texcoord_y};
-        }
+    sprites.requested_capacity = 0;
 
-        // color
-        {
-            sprites.vertex_data[i * 4 + 0].color = sprite->color;
-            sprites.vertex_data[i * 4 + 1].color = sprite->color;
-            sprites.vertex_data[i * 4 + 2].color = sprite->color;
-            sprites.vertex_data[i * 4 + 3].color = sprite->color;
-        }
+    // Only move on once the region has been written, acquiring again would eventually wrap onto the rendered one.
+    if (first_swap || published) {
+        sprites.write_region = fence_ring::acquire(*sprites.fences);
     }
-
-    hash::clear(sprites.transforms);
 }
 
 void render_sprites(const Engine &engine, const Sprites &sprites) {
-    std::scoped_lock lock(*sprites.sprites_mutex);
 
-    if (!(sprites.shader && sprites.shader->program && sprites.vao && sprites.ebo && sprites.atlas)) {
+    if (!(sprites.shader && sprites.shader->program && sprites.vao && sprites.ebo)) {
         return;
     }
 
@@ -473,7 +1619,6 @@ void render_sprites(const Engine &engine, const Sprites &sprites) {
     glUseProgram(shader_program);
     glBindVertexArray(sprites.vao);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, sprites.atlas->texture->texture);
     glUniform1i(glGetUniformLocation(shader_program, "texture0"), 0);
 
     glm::mat4 model = glm::mat4(1);
@@ -482,14 +1627,22 @@ void render_sprites(const Engine &engine, const Sprites &sprites) {
     glUniformMatrix4fv(glGetUniformLocation(shader_program, "projection"), 1, GL_FALSE, glm::value_ptr(projection * view));
     glUniformMatrix4fv(glGetUniformLocation(shader_program, "model"), 1, GL_FALSE, glm::value_ptr(model));
 
-    uint64_t quads = array::size(sprites.sprites);
+    const GLint base_vertex = (GLint)((size_t)sprites.render_region * sprites.capacity * 4);
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDisable(GL_DEPTH_TEST);
 
-//    glDrawElements(GL_TRIANGLES, 6 * (GLsizei)quads, GL_UNSIGNED_INT, array::begin(sprites.sprite_indices));
-    glDrawElements(GL_TRIANGLES, 6 * (GLsizei)quads, GL_UNSIGNED_INT, (void *)0);
+    for (uint32_t i = 0; i < array::size(sprites.render_batches); ++i) {
+        const SpriteBatch &batch = sprites.render_batches[i];
+        glBindTexture(GL_TEXTURE_2D, sprites.render_textures[i]);
+
+        const size_t index_offset = sizeof(GLuint) * 6 * (size_t)batch.first;
+        glDrawElementsBaseVertex(GL_TRIANGLES, 6 * (GLsizei)batch.count, GL_UNSIGNED_INT, (void *)index_offset, base_vertex);
+    }
+
+    // The next commits write to other regions until this one has been read.
+    fence_ring::fence(*sprites.fences, sprites.render_region);
 
     glEnable(GL_DEPTH_TEST);
     glDisable(GL_BLEND);
@@ -498,4 +1651,8 @@ void render_sprites(const Engine &engine, const Sprites &sprites) {
     glPopDebugGroup();
 }
 
+uint32_t sprites_draw_calls(const Sprites &sprites) {
+    return array::size(sprites.render_batches);
+}
+
 } // namespace engine
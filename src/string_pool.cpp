@@ -0,0 +1,62 @@
+#include "engine/string_pool.h"
+#include "engine/log.h"
+
+#include <array.h>
+#include <hash.h>
+#include <murmur_hash.h>
+#include <string.h>
+#include <string_stream.h>
+
+namespace engine {
+
+StringPool::StringPool(Allocator &allocator)
+: strings(allocator)
+, offsets(allocator) {}
+
+namespace string_pool {
+
+NameId name_id(const char *string, uint32_t length) {
+    return murmur_hash_64(string, length, 0);
+}
+
+NameId intern(StringPool &pool, const char *string, uint32_t length) {
+    const NameId id = name_id(string, length);
+
+    const Hash<uint32_t>::Entry *entry = multi_hash::find_first(pool.offsets, id);
+    if (entry) {
+        const char *interned = array::begin(pool.strings) + entry->value;
+        if (strncmp(interned, string, length) != 0 || interned[length] != '\0') {
+            log_fatal("Could not intern %.*s, it has the same id as %s", (int)length, string, interned);
+        }
+
+        return id;
+    }
+
+    hash::set(pool.offsets, id, array::size(pool.strings));
+    string_stream::push(pool.strings, string, length);
+    array::push_back(pool.strings, '\0');
+
+    return id;
+}
+
+NameId intern(StringPool &pool, const char *string) {
+    return intern(pool, string, (uint32_t)strlen(string));
+}
+
+const char *get(const StringPool &pool, NameId id) {
+    const Hash<uint32_t>::Entry *entry = multi_hash::find_first(pool.offsets, id);
+    return entry ? array::begin(pool.strings) + entry->value : nullptr;
+}
+
+void reserve(StringPool &pool, uint32_t count, uint32_t size) {
+    array::reserve(pool.strings, size + count);
+    hash::reserve(pool.offsets, count);
+}
+
+void clear(StringPool &pool) {
+    array::clear(pool.strings);
+    hash::clear(pool.offsets);
+}
+
+} // namespace string_pool
+} // namespace engine
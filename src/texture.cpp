@@ -1,15 +1,100 @@
 #include "engine/texture.h"
+#include "engine/file.h"
 #include "engine/log.h"
+#include "engine/mipmap.inl"
+#include "engine/pixels.inl"
+#include "engine/texture_cache.inl"
 
 #include <GLFW/glfw3.h>
 #include <algorithm>
 #include <cstring>
 #include <glad/glad.h>
 #include <memory.h>
+#include <string_stream.h>
+#include <temp_allocator.h>
 
 using namespace foundation;
 
 namespace {
+using namespace engine;
+
+GLint gl_filter(TextureFilter filter, bool mipmaps) {
+    if (filter == TextureFilter::Linear) {
+        return mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+    }
+
+    return mipmaps ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST;
+}
+
+// Creates a texture from RGBA8 pixels, with its mip levels if the options ask for them.
+uint32_t upload(Allocator &allocator, const uint8_t *pixels, int width, int height, const TextureOptions &options) {
+    const uint32_t max_level = options.mipmaps ? mipmap::max_level(width, height, options.atlas_padding) : 0;
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter(options.min_filter, max_level > 0));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter(options.mag_filter, false));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)max_level);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    if (max_level == 0) {
+        return texture;
+    }
+
+    // The levels after the first share one allocation, each filtered from the one before.
+    size_t levels_size = 0;
+    for (uint32_t level = 1; level <= max_level; ++level) {
+        levels_size += (size_t)mipmap::level_size(width, level) * mipmap::level_size(height, level) * 4;
+    }
+
+    uint8_t *levels = (uint8_t *)allocator.allocate((uint32_t)levels_size);
+    const uint8_t *source = pixels;
+    uint8_t *destination = levels;
+
+    for (uint32_t level = 1; level <= max_level; ++level) {
+        const int32_t source_width = mipmap::level_size(width, level - 1);
+        const int32_t source_height = mipmap::level_size(height, level - 1);
+        const int32_t level_width = mipmap::level_size(width, level);
+        const int32_t level_height = mipmap::level_size(height, level);
+
+        mipmap::downsample(source, source_width, source_height, destination);
+        glTexImage2D(GL_TEXTURE_2D, (GLint)level, GL_RGBA, level_width, level_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, destination);
+
+        source = destination;
+        destination += (size_t)level_width * level_height * 4;
+    }
+
+    allocator.deallocate(levels);
+    return texture;
+}
+
+// Uploads a texture straight from its mapped cache file, if the cache is up to date with the source image.
+bool load_cached(Allocator &allocator, Texture &texture, const char *cache_filename, const file::FileInfo &source, const TextureOptions &options) {
+    if (!file::exist(cache_filename)) {
+        return false;
+    }
+
+    file::MappedFile mapped;
+    if (!file::map(mapped, cache_filename)) {
+        return false;
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const uint8_t *pixels = texture_cache::pixels(mapped.data, mapped.size, source.size, source.modified, width, height);
+
+    if (pixels) {
+        texture.width = (int)width;
+        texture.height = (int)height;
+        texture.texture = upload(allocator, pixels, texture.width, texture.height, options);
+    }
+
+    file::unmap(mapped);
+    return pixels != nullptr;
+}
 
 /*
 void *__malloc(size_t size) {
@@ -52,44 +137,53 @@ void __free(void *ptr) {
 
 namespace engine {
 
-Texture::Texture(Allocator &allocator, const char *texture_filename)
+Texture::Texture(Allocator &allocator, const char *texture_filename, const TextureOptions &options)
 : width(0)
-, height(0) {
+, height(0)
+, texture(0) {
+    using namespace string_stream;
+
+    TempAllocator512 ta;
+    Buffer cache_filename(ta);
+    file::FileInfo source;
+    bool cache = false;
+
+    if (options.cache) {
+        printf(cache_filename, "%s%s", texture_filename, texture_cache::suffix);
+        cache = file::info(source, texture_filename);
+
+        if (cache && load_cached(allocator, *this, c_str(cache_filename), source, options)) {
+            return;
+        }
+    }
+
     int channels = 0;
     unsigned char *data = stbi_load(texture_filename, &width, &height, &channels, 0);
     if (!data) {
         log_fatal("Couldn't load texture %s: %s", texture_filename, stbi_failure_reason());
     }
 
+    // When caching, the pixels are expanded right after the cache header so the file is written in one go.
+    const uint32_t header_size = cache ? sizeof(TextureCacheHeader) : 0;
+    const uint32_t pixels_size = width * height * 4;
     unsigned char *padded_data = nullptr;
 
-    if (channels != 4) {
-        padded_data = (unsigned char *)allocator.allocate(width * height * 4);
-        for (int x = 0; x < width; ++x) {
-            for (int y = 0; y < height; ++y) {
-                if (channels == 3) {
-                    padded_data[(y * width + x) * 4 + 0] = data[(y * width + x) * 3 + 0];
-                    padded_data[(y * width + x) * 4 + 1] = data[(y * width + x) * 3 + 1];
-                    padded_data[(y * width + x) * 4 + 2] = data[(y * width + x) * 3 + 2];
-                } else if (channels == 1) {
-                    unsigned char val = data[(y * width + x) * 1 + 0];
-                    padded_data[(y * width + x) * 4 + 0] = val;
-                    padded_data[(y * width + x) * 4 + 1] = val;
-                    padded_data[(y * width + x) * 4 + 2] = val;
-                }
-                padded_data[(y * width + x) * 4 + 3] = 255;
-            }
+    if (channels != 4 || cache) {
+        padded_data = (unsigned char *)allocator.allocate(header_size + pixels_size);
+        if (!pixels::to_rgba(data, channels, padded_data + header_size, (size_t)width * height)) {
+            log_fatal("Couldn't load texture %s: unsupported %d channels", texture_filename, channels);
         }
     }
 
-    // normal texture
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, padded_data == nullptr ? data : padded_data);
+    texture = upload(allocator, padded_data == nullptr ? data : padded_data + header_size, width, height, options);
+
+    // Failing to write the cache, like in a read-only asset directory, only costs decoding again next time.
+    if (cache) {
+        TextureCacheHeader header;
+        texture_cache::init_header(header, (uint32_t)width, (uint32_t)height, source.size, source.modified);
+        memcpy(padded_data, &header, sizeof(header));
+        file::replace(c_str(cache_filename), padded_data, header_size + pixels_size);
+    }
 
     if (padded_data != nullptr) {
         allocator.deallocate(padded_data);
@@ -98,4 +192,10 @@ Texture::Texture(Allocator &allocator, const char *texture_filename)
     stbi_image_free(data);
 }
 
+Texture::Texture(int width, int height, uint32_t texture)
+: width(width)
+, height(height)
+, texture(texture) {
+}
+
 } // namespace engine
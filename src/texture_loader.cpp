@@ -0,0 +1,235 @@
+#include "engine/texture_loader.h"
+#include "engine/log.h"
+#include "engine/texture.h"
+#include "engine/thread_pool.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <array.h>
+#include <atomic>
+#include <cassert>
+#include <glad/glad.h>
+#include <limits>
+#include <memory.h>
+#include <string.h>
+#include <thread>
+
+#include "engine/stb_image.h"
+
+namespace engine {
+
+// A texture loading on a TextureLoader. Shared with the worker thread decoding it while the state is Decoding.
+struct LoadingTexture {
+    char *filename;
+    std::atomic<TextureState> state;
+    int width;
+    int height;
+    unsigned char *pixels;      // RGBA8 rows from stbi_load, freed once uploaded.
+    const char *failure_reason; // Set by the worker when decoding fails, logged on the GL thread.
+    bool failure_logged;
+    uint32_t uploaded_rows;
+    Texture *texture; // Created when the upload starts.
+};
+
+} // namespace engine
+
+namespace {
+using namespace engine;
+
+// The most bytes staged in the pixel buffer and uploaded at once, which bounds the time of a single step.
+const uint32_t max_strip_bytes = 4 * 1024 * 1024;
+
+void decode(void *data) {
+    LoadingTexture *loading = (LoadingTexture *)data;
+
+    int channels = 0;
+    loading->pixels = stbi_load(loading->filename, &loading->width, &loading->height, &channels, 4);
+
+    if (!loading->pixels) {
+        loading->failure_reason = stbi_failure_reason();
+        loading->state.store(TextureState::Failed, std::memory_order_release);
+        return;
+    }
+
+    // Last access, the loader may upload and free the texture after this.
+    loading->state.store(TextureState::Uploading, std::memory_order_release);
+}
+
+// Uploads the next strip of rows of a decoded texture through the pixel buffer.
+void upload_strip(TextureLoader &loader, LoadingTexture &loading) {
+    if (!loading.texture) {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, loading.width, loading.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        loading.texture = MAKE_NEW(loader.allocator, Texture, loading.width, loading.height, texture);
+    }
+
+    if (!loader.pixel_buffer) {
+        glGenBuffers(1, &loader.pixel_buffer);
+    }
+
+    const uint32_t row_bytes = (uint32_t)loading.width * 4;
+    const uint32_t strip_rows = std::min(std::max(max_strip_bytes / row_bytes, 1u), (uint32_t)loading.height - loading.uploaded_rows);
+    const uint32_t strip_bytes = strip_rows * row_bytes;
+    const unsigned char *strip = loading.pixels + (size_t)loading.uploaded_rows * row_bytes;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, loader.pixel_buffer);
+
+    // Orphans the storage of the previous strip, so staging this one doesn't wait for the GPU to copy that one.
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, strip_bytes, nullptr, GL_STREAM_DRAW);
+
+    void *staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, strip_bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    const void *pixels = nullptr;
+    if (staging) {
+        memcpy(staging, strip, strip_bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pixels = strip;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, loading.texture->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, loading.uploaded_rows, loading.width, strip_rows, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    loading.uploaded_rows += strip_rows;
+
+    if (loading.uploaded_rows == (uint32_t)loading.height) {
+        stbi_image_free(loading.pixels);
+        loading.pixels = nullptr;
+        loading.state.store(TextureState::Ready, std::memory_order_relaxed);
+    }
+}
+
+// Whether upload_textures has nothing left to do for a texture.
+bool finished(const LoadingTexture &loading) {
+    const TextureState state = loading.state.load(std::memory_order_acquire);
+    return state == TextureState::Ready || (state == TextureState::Failed && loading.failure_logged);
+}
+
+} // namespace
+
+namespace engine {
+
+TextureLoader::TextureLoader(Allocator &allocator, ThreadPool &thread_pool)
+: allocator(allocator)
+, thread_pool(thread_pool)
+, textures(nullptr)
+, next_upload(0)
+, pixel_buffer(0) {
+    textures = MAKE_NEW(allocator, Array<LoadingTexture *>, allocator);
+}
+
+TextureLoader::~TextureLoader() {
+    for (uint32_t i = 0; i < array::size(*textures); ++i) {
+        LoadingTexture *loading = (*textures)[i];
+
+        // The decode job still holds the texture.
+        while (loading->state.load(std::memory_order_acquire) == TextureState::Decoding) {
+            std::this_thread::yield();
+        }
+
+        if (loading->texture) {
+            glDeleteTextures(1, &loading->texture->texture);
+            MAKE_DELETE(allocator, Texture, loading->texture);
+        }
+
+        if (loading->pixels) {
+            stbi_image_free(loading->pixels);
+        }
+
+        allocator.deallocate(loading->filename);
+        MAKE_DELETE(allocator, LoadingTexture, loading);
+    }
+
+    if (pixel_buffer) {
+        glDeleteBuffers(1, &pixel_buffer);
+    }
+
+    MAKE_DELETE(allocator, Array, textures);
+}
+
+TextureHandle load_texture(TextureLoader &loader, const char *texture_filename) {
+    const size_t length = strlen(texture_filename);
+
+    LoadingTexture *loading = MAKE_NEW(loader.allocator, LoadingTexture);
+    loading->filename = (char *)loader.allocator.allocate((uint32_t)length + 1);
+    memcpy(loading->filename, texture_filename, length + 1);
+    loading->state.store(TextureState::Decoding, std::memory_order_relaxed);
+    loading->width = 0;
+    loading->height = 0;
+    loading->pixels = nullptr;
+    loading->failure_reason = nullptr;
+    loading->failure_logged = false;
+    loading->uploaded_rows = 0;
+    loading->texture = nullptr;
+
+    const TextureHandle handle = array::size(*loader.textures);
+    array::push_back(*loader.textures, loading);
+
+    submit(loader.thread_pool, {decode, loading});
+
+    return handle;
+}
+
+TextureState texture_state(const TextureLoader &loader, TextureHandle handle) {
+    assert(handle < array::size(*loader.textures));
+    return (*loader.textures)[handle]->state.load(std::memory_order_acquire);
+}
+
+bool texture_ready(const TextureLoader &loader, TextureHandle handle) {
+    return texture_state(loader, handle) == TextureState::Ready;
+}
+
+const Texture *loaded_texture(const TextureLoader &loader, TextureHandle handle) {
+    return texture_ready(loader, handle) ? (*loader.textures)[handle]->texture : nullptr;
+}
+
+bool upload_textures(TextureLoader &loader, double budget_seconds) {
+    const double start = glfwGetTime();
+
+    while (loader.next_upload < array::size(*loader.textures) && finished(*(*loader.textures)[loader.next_upload])) {
+        ++loader.next_upload;
+    }
+
+    bool loading = false;
+    bool uploaded = false;
+
+    // Textures upload in the order they were queued, skipping those still decoding.
+    for (uint32_t i = loader.next_upload; i < array::size(*loader.textures); ++i) {
+        LoadingTexture &texture = *(*loader.textures)[i];
+        const TextureState state = texture.state.load(std::memory_order_acquire);
+
+        if (state == TextureState::Failed && !texture.failure_logged) {
+            log_error("Couldn't load texture %s: %s", texture.filename, texture.failure_reason);
+            texture.failure_logged = true;
+        } else if (state == TextureState::Decoding) {
+            loading = true;
+        }
+
+        while (texture.state.load(std::memory_order_relaxed) == TextureState::Uploading) {
+            if (uploaded && glfwGetTime() - start >= budget_seconds) {
+                return true;
+            }
+
+            upload_strip(loader, texture);
+            uploaded = true;
+        }
+    }
+
+    return loading;
+}
+
+void finish_textures(TextureLoader &loader) {
+    while (upload_textures(loader, std::numeric_limits<double>::infinity())) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace engine
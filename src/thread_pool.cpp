@@ -0,0 +1,207 @@
+#include "engine/thread_pool.h"
+
+#include <algorithm>
+#include <array.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory.h>
+#include <mutex>
+#include <queue.h>
+#include <thread>
+
+namespace engine {
+
+// Shared between the calling thread and the helper jobs of a parallel_for. Helpers still queued when the call
+// returns run later and find no chunks left, so it's held by references instead of living on the caller's stack.
+struct ParallelFor {
+    void (*function)(void *data, uint32_t begin, uint32_t end);
+    void *data;
+    uint32_t count;
+    uint32_t chunk_size;
+    uint32_t chunk_count;
+    std::atomic<uint32_t> next_chunk;
+    std::atomic<uint32_t> done_chunks;
+    std::atomic<uint32_t> references;
+    ThreadPool *pool;
+    ParallelFor *next_free;
+};
+
+} // namespace engine
+
+namespace {
+using namespace engine;
+
+void worker(ThreadPool *pool) {
+    while (true) {
+        Job job;
+
+        {
+            std::unique_lock lock(*pool->mutex);
+            pool->condition->wait(lock, [pool] {
+                return pool->stopping || queue::size(*pool->jobs) > 0;
+            });
+
+            if (queue::size(*pool->jobs) == 0) {
+                return;
+            }
+
+            job = (*pool->jobs)[0];
+            queue::pop_front(*pool->jobs);
+        }
+
+        job.function(job.data);
+    }
+}
+
+void run_chunks(ParallelFor &pf) {
+    while (true) {
+        const uint32_t chunk = pf.next_chunk.fetch_add(1);
+        if (chunk >= pf.chunk_count) {
+            return;
+        }
+
+        const uint32_t begin = chunk * pf.chunk_size;
+        const uint32_t end = std::min(begin + pf.chunk_size, pf.count);
+        pf.function(pf.data, begin, end);
+        pf.done_chunks.fetch_add(1);
+    }
+}
+
+// Takes a parallel_for state off the pool's free list, or makes a new one.
+ParallelFor *acquire_parallel_for(ThreadPool &pool) {
+    {
+        std::scoped_lock lock(*pool.mutex);
+
+        ParallelFor *pf = pool.free_parallel_fors;
+        if (pf) {
+            pool.free_parallel_fors = pf->next_free;
+            return pf;
+        }
+    }
+
+    return MAKE_NEW(pool.allocator, ParallelFor);
+}
+
+// Drops a reference to a parallel_for state, the last one returns it to the pool's free list.
+void release_parallel_for(ParallelFor *pf) {
+    if (pf->references.fetch_sub(1) != 1) {
+        return;
+    }
+
+    ThreadPool &pool = *pf->pool;
+    std::scoped_lock lock(*pool.mutex);
+    pf->next_free = pool.free_parallel_fors;
+    pool.free_parallel_fors = pf;
+}
+
+void parallel_for_helper(void *data) {
+    ParallelFor *pf = (ParallelFor *)data;
+    run_chunks(*pf);
+    release_parallel_for(pf);
+}
+
+} // namespace
+
+namespace engine {
+
+ThreadPool::ThreadPool(Allocator &allocator, uint32_t thread_count)
+: allocator(allocator)
+, thread_count(thread_count)
+, stopping(false)
+, mutex(nullptr)
+, condition(nullptr)
+, jobs(nullptr)
+, threads(nullptr)
+, free_parallel_fors(nullptr) {
+    if (this->thread_count == 0) {
+        this->thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    mutex = MAKE_NEW(allocator, std::mutex);
+    condition = MAKE_NEW(allocator, std::condition_variable);
+    jobs = MAKE_NEW(allocator, Queue<Job>, allocator);
+    threads = MAKE_NEW(allocator, Array<std::thread *>, allocator);
+
+    for (uint32_t i = 0; i < this->thread_count; ++i) {
+        std::thread *thread = MAKE_NEW(allocator, std::thread, worker, this);
+        array::push_back(*threads, thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::scoped_lock lock(*mutex);
+        stopping = true;
+    }
+
+    condition->notify_all();
+
+    for (uint32_t i = 0; i < array::size(*threads); ++i) {
+        std::thread *t = (*threads)[i];
+        t->join();
+        MAKE_DELETE(allocator, thread, t);
+    }
+
+    // The workers ran every queued job before exiting, so every parallel_for state is back on the free list.
+    while (free_parallel_fors) {
+        ParallelFor *pf = free_parallel_fors;
+        free_parallel_fors = pf->next_free;
+        MAKE_DELETE(allocator, ParallelFor, pf);
+    }
+
+    MAKE_DELETE(allocator, Array, threads);
+    MAKE_DELETE(allocator, Queue, jobs);
+    MAKE_DELETE(allocator, condition_variable, condition);
+    MAKE_DELETE(allocator, mutex, mutex);
+}
+
+void submit(ThreadPool &pool, Job job) {
+    {
+        std::scoped_lock lock(*pool.mutex);
+        queue::push_back(*pool.jobs, job);
+    }
+
+    pool.condition->notify_one();
+}
+
+void parallel_for(ThreadPool &pool, uint32_t count, uint32_t min_chunk, void (*function)(void *data, uint32_t begin, uint32_t end), void *data) {
+    min_chunk = std::max(min_chunk, 1u);
+
+    if (count < min_chunk * 2 || pool.thread_count == 0) {
+        function(data, 0, count);
+        return;
+    }
+
+    // A few chunks per thread evens out uneven work, but never smaller than min_chunk.
+    const uint32_t participants = pool.thread_count + 1;
+    const uint32_t chunk_size = std::max(min_chunk, (count + participants * 4 - 1) / (participants * 4));
+    const uint32_t chunk_count = (count + chunk_size - 1) / chunk_size;
+    const uint32_t helpers = std::min(pool.thread_count, chunk_count - 1);
+
+    ParallelFor *pf = acquire_parallel_for(pool);
+    pf->function = function;
+    pf->data = data;
+    pf->count = count;
+    pf->chunk_size = chunk_size;
+    pf->chunk_count = chunk_count;
+    pf->next_chunk = 0;
+    pf->done_chunks = 0;
+    pf->references = helpers + 1;
+    pf->pool = &pool;
+    pf->next_free = nullptr;
+
+    for (uint32_t i = 0; i < helpers; ++i) {
+        submit(pool, {parallel_for_helper, pf});
+    }
+
+    run_chunks(*pf);
+
+    // Only chunks helpers have claimed can still be running. Helpers that haven't started never get any.
+    while (pf->done_chunks.load() < chunk_count) {
+        std::this_thread::yield();
+    }
+
+    release_parallel_for(pf);
+}
+
+} // namespace engine
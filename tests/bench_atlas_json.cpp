@@ -0,0 +1,81 @@
+#include "../engine/atlas_json.inl"
+#include <chrono>
+#include <stdio.h>
+#include <string>
+
+// Generates a TexturePacker JSON-Array atlas with frame_count frames, formatted like TexturePacker writes them.
+std::string generate_atlas(uint32_t frame_count) {
+    std::string json = "{\"frames\": [\n";
+    char frame[512];
+
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        const uint32_t x = (i % 256) * 32;
+        const uint32_t y = (i / 256) * 32;
+        snprintf(frame, sizeof(frame),
+                 "{\n"
+                 "\t\"filename\": \"sprites/characters/character_%05u.png\",\n"
+                 "\t\"frame\": {\"x\":%u,\"y\":%u,\"w\":32,\"h\":32},\n"
+                 "\t\"rotated\": false,\n"
+                 "\t\"trimmed\": true,\n"
+                 "\t\"spriteSourceSize\": {\"x\":1,\"y\":2,\"w\":32,\"h\":32},\n"
+                 "\t\"sourceSize\": {\"w\":34,\"h\":36},\n"
+                 "\t\"pivot\": {\"x\":0.5,\"y\":0.25}\n"
+                 "}%s\n",
+                 i, x, y, i + 1 < frame_count ? "," : "");
+        json += frame;
+    }
+
+    json += "],\n\"meta\": {\n"
+            "\t\"app\": \"https://www.codeandweb.com/texturepacker\",\n"
+            "\t\"version\": \"1.0\",\n"
+            "\t\"image\": \"atlas.png\",\n"
+            "\t\"format\": \"RGBA8888\",\n"
+            "\t\"size\": {\"w\":8192,\"h\":8192},\n"
+            "\t\"scale\": \"1\"\n"
+            "}\n}\n";
+
+    return json;
+}
+
+// Reports the throughput of parsing generated atlases of 1k to 100k frames with atlas_json::parse.
+int main(int, char **) {
+    using clock = std::chrono::high_resolution_clock;
+
+    const uint32_t frame_counts[] = {1000, 10000, 50000, 100000};
+    const int iterations = 10;
+
+    printf("frames      size (MB)  parse (ms)  throughput (MB/s)\n");
+
+    for (uint32_t frame_count : frame_counts) {
+        const std::string json = generate_atlas(frame_count);
+        double best_ms = 1e9;
+        volatile uint64_t checksum = 0;
+
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            const char *error = nullptr;
+            uint32_t error_offset = 0;
+
+            const auto start = clock::now();
+            const bool parsed = engine::atlas_json::parse(
+                json.data(), (uint32_t)json.size(),
+                [](const engine::AtlasJsonMeta &) {},
+                [&checksum](const engine::AtlasJsonFrame &frame) {
+                    checksum = checksum + frame.name_length + frame.rect.origin.x;
+                },
+                error, error_offset);
+            const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+            if (!parsed) {
+                printf("parse failed: %s at %u\n", error, error_offset);
+                return 1;
+            }
+
+            best_ms = ms < best_ms ? ms : best_ms;
+        }
+
+        const double megabytes = json.size() / (1024.0 * 1024.0);
+        printf("%6u  %13.2f  %10.2f  %17.1f\n", frame_count, megabytes, best_ms, megabytes / (best_ms / 1000.0));
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "../engine/mpsc_queue.inl"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A sprite command sized payload, roughly what transform_sprite enqueues.
+struct Payload {
+    uint64_t id;
+    float transform[16];
+    float color[4];
+};
+
+const uint32_t per_producer = 200000;
+
+// The baseline, a queue behind a mutex like the sprites mutex.
+struct LockedQueue {
+    std::mutex mutex;
+    std::deque<Payload> payloads;
+};
+
+template <typename Push, typename Pop>
+double run(uint32_t producer_count, Push push, Pop pop) {
+    using clock = std::chrono::high_resolution_clock;
+
+    const auto start = clock::now();
+
+    std::vector<std::thread> producers;
+    for (uint32_t producer = 0; producer < producer_count; ++producer) {
+        producers.emplace_back([&push, producer]() {
+            Payload payload = {};
+            for (uint32_t i = 0; i < per_producer; ++i) {
+                payload.id = ((uint64_t)producer << 32) | i;
+                push(payload);
+            }
+        });
+    }
+
+    uint64_t received = 0;
+    Payload payload;
+    while (received < (uint64_t)producer_count * per_producer) {
+        if (pop(payload)) {
+            ++received;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for (std::thread &thread : producers) {
+        thread.join();
+    }
+
+    return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+}
+
+} // namespace
+
+// Compares producers pushing sprite commands through the lock-free queue against a mutex guarded queue,
+// with one thread draining, for 1 to 8 producers.
+int main(int, char **) {
+    printf("%u commands per producer\n", per_producer);
+    printf("producers  mutex (ms)  lock-free (ms)\n");
+
+    for (uint32_t producer_count = 1; producer_count <= 8; ++producer_count) {
+        LockedQueue *locked = new LockedQueue();
+        const double locked_ms = run(
+            producer_count,
+            [locked](const Payload &payload) {
+                std::scoped_lock lock(locked->mutex);
+                locked->payloads.push_back(payload);
+            },
+            [locked](Payload &payload) {
+                std::scoped_lock lock(locked->mutex);
+                if (locked->payloads.empty()) {
+                    return false;
+                }
+                payload = locked->payloads.front();
+                locked->payloads.pop_front();
+                return true;
+            });
+        delete locked;
+
+        engine::MPSCQueue<Payload, 8192> *queue = new engine::MPSCQueue<Payload, 8192>();
+        const double lock_free_ms = run(
+            producer_count,
+            [queue](const Payload &payload) {
+                engine::mpsc_queue::push(*queue, payload);
+            },
+            [queue](Payload &payload) {
+                return engine::mpsc_queue::try_pop(*queue, payload);
+            });
+        delete queue;
+
+        printf("%9u  %10.2f  %14.2f\n", producer_count, locked_ms, lock_free_ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "../engine/math.inl"
+#include "../engine/sprite_vertices.inl"
+#include "../engine/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <memory.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint32_t sprite_count = 1000000;
+const int iterations = 20;
+
+// The chunking commit_sprites uses.
+const uint32_t parallel_commit_chunk = 4096;
+
+// The sprite data commit_sprites reads, a transform, a frame's texture coords and a packed color.
+struct SpriteData {
+    math::Transform2D transform;
+    uint16_t texture_coords[4][2];
+    uint32_t color;
+};
+
+// Sprites in draw order, and the region of the vertex buffer a commit writes.
+struct CommitJob {
+    const SpriteData *sprites;
+    const uint32_t *draw_order;
+    math::PackedVertex *vertex_data;
+};
+
+void write_vertices(void *data, uint32_t begin, uint32_t end) {
+    const CommitJob *job = (const CommitJob *)data;
+
+    for (uint32_t i = begin; i < end; ++i) {
+        const SpriteData &sprite = job->sprites[job->draw_order[i]];
+        engine::write_sprite_vertices(&job->vertex_data[(size_t)i * 4], sprite.transform, sprite.texture_coords, sprite.color);
+    }
+}
+
+} // namespace
+
+// Measures writing the vertices of 1M sorted sprites like commit_sprites, on the calling thread alone and with
+// parallel_for on pools of 1 to N - 1 workers. Usage: bench_parallel_commit [max threads]
+int main(int argc, char **argv) {
+    using namespace engine;
+    using namespace foundation;
+    using clock = std::chrono::high_resolution_clock;
+
+    const uint32_t max_threads = argc > 1 ? (uint32_t)atoi(argv[1]) : std::max(std::thread::hardware_concurrency(), 1u);
+
+    memory_globals::init();
+
+    {
+        std::vector<SpriteData> sprites(sprite_count);
+        std::vector<uint32_t> draw_order(sprite_count);
+        std::vector<math::PackedVertex> vertex_data((size_t)sprite_count * 4);
+
+        srand(1);
+        for (uint32_t i = 0; i < sprite_count; ++i) {
+            SpriteData &sprite = sprites[i];
+            sprite.transform.x_axis = {32.0f, 0.0f};
+            sprite.transform.y_axis = {0.0f, 32.0f};
+            sprite.transform.origin = {(float)(rand() % 100000), (float)(rand() % 100000)};
+            sprite.transform.z = (float)(rand() % 100);
+
+            for (int ii = 0; ii < 4; ++ii) {
+                sprite.texture_coords[ii][0] = (uint16_t)rand();
+                sprite.texture_coords[ii][1] = (uint16_t)rand();
+            }
+
+            sprite.color = 0xffffffff;
+            draw_order[i] = i;
+        }
+
+        // Sorted draw order jumps around the sprite array.
+        std::shuffle(draw_order.begin(), draw_order.end(), std::mt19937(1));
+
+        CommitJob job;
+        job.sprites = sprites.data();
+        job.draw_order = draw_order.data();
+        job.vertex_data = vertex_data.data();
+
+        printf("%u sprites, average of %d commits\n", sprite_count, iterations);
+        printf("threads  commit (ms)  speedup\n");
+
+        double single_ms = 0.0;
+        for (uint32_t thread_count = 1; thread_count <= max_threads; ++thread_count) {
+            ThreadPool *pool = thread_count > 1 ? MAKE_NEW(memory_globals::default_allocator(), ThreadPool, memory_globals::default_allocator(), thread_count - 1) : nullptr;
+
+            double ms = 0.0;
+            for (int iteration = 0; iteration < iterations; ++iteration) {
+                const auto start = clock::now();
+
+                if (pool) {
+                    parallel_for(*pool, sprite_count, parallel_commit_chunk, write_vertices, &job);
+                } else {
+                    write_vertices(&job, 0, sprite_count);
+                }
+
+                ms += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            }
+
+            ms /= iterations;
+            if (thread_count == 1) {
+                single_ms = ms;
+            }
+
+            printf("%7u  %11.2f  %7.2f\n", thread_count, ms, single_ms / ms);
+
+            if (pool) {
+                MAKE_DELETE(memory_globals::default_allocator(), ThreadPool, pool);
+            }
+        }
+    }
+
+    memory_globals::shutdown();
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "../engine/pixels.inl"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+const int size = 4096;
+
+// The conversion Texture and init_canvas did before, column by column.
+void column_major(const uint8_t *data, int channels, uint8_t *padded_data) {
+    for (int x = 0; x < size; ++x) {
+        for (int y = 0; y < size; ++y) {
+            if (channels == 3) {
+                padded_data[(y * size + x) * 4 + 0] = data[(y * size + x) * 3 + 0];
+                padded_data[(y * size + x) * 4 + 1] = data[(y * size + x) * 3 + 1];
+                padded_data[(y * size + x) * 4 + 2] = data[(y * size + x) * 3 + 2];
+            } else if (channels == 1) {
+                const uint8_t val = data[y * size + x];
+                padded_data[(y * size + x) * 4 + 0] = val;
+                padded_data[(y * size + x) * 4 + 1] = val;
+                padded_data[(y * size + x) * 4 + 2] = val;
+            }
+            padded_data[(y * size + x) * 4 + 3] = 255;
+        }
+    }
+}
+
+template <typename Convert>
+double best_ms(Convert convert) {
+    using clock = std::chrono::high_resolution_clock;
+
+    double best = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        const auto start = clock::now();
+        convert();
+        const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        best = ms < best ? ms : best;
+    }
+
+    return best;
+}
+
+} // namespace
+
+// Compares converting a 4096x4096 gray and RGB image to RGBA column by column against the row-major pixels kernels.
+// Build with CHOCOLATE_AVX2 to measure the SSSE3 and AVX2 kernels.
+int main(int, char **) {
+    const size_t count = (size_t)size * size;
+    std::vector<uint8_t> source(count * 3);
+    std::vector<uint8_t> rgba(count * 4);
+
+    for (size_t i = 0; i < source.size(); ++i) {
+        source[i] = (uint8_t)rand();
+    }
+
+    printf("%dx%d      column-major (ms)  pixels (ms)  speedup\n", size, size);
+
+    const int channels[] = {1, 3};
+    const char *names[] = {"gray", "rgb "};
+    void (*const kernels[])(const uint8_t *, uint8_t *, size_t) = {engine::pixels::gray_to_rgba, engine::pixels::rgb_to_rgba};
+
+    for (int i = 0; i < 2; ++i) {
+        const double column_ms = best_ms([&]() {
+            column_major(source.data(), channels[i], rgba.data());
+        });
+
+        const double pixels_ms = best_ms([&]() {
+            kernels[i](source.data(), rgba.data(), count);
+        });
+
+        printf("%s -> rgba  %17.2f  %11.2f  %7.1f\n", names[i], column_ms, pixels_ms, column_ms / pixels_ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "../engine/radix_sort.inl"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Compares depth sorting 1M sprite depths with std::sort against the radix sort used by commit_sprites.
+int main(int, char **) {
+    using clock = std::chrono::high_resolution_clock;
+
+    const uint32_t count = 1000000;
+    const int iterations = 10;
+
+    float *depths = new float[count];
+    uint32_t *keys = new uint32_t[count * 2];
+    uint32_t *indices = new uint32_t[count * 2];
+    float *sorted_depths = new float[count];
+
+    srand(1);
+    for (uint32_t i = 0; i < count; ++i) {
+        depths[i] = (float)(rand() % 20000 - 10000) / 100.0f;
+    }
+
+    double std_sort_ms = 0.0;
+    double radix_sort_ms = 0.0;
+
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        std::copy(depths, depths + count, sorted_depths);
+
+        auto start = clock::now();
+        std::sort(sorted_depths, sorted_depths + count);
+        std_sort_ms += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        for (uint32_t i = 0; i < count; ++i) {
+            keys[i] = engine::radix_sort::float_key(depths[i]);
+            indices[i] = i;
+        }
+        engine::radix_sort::sort(keys, indices, keys + count, indices + count, count);
+        radix_sort_ms += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    }
+
+    printf("%u depths, average of %d runs\n", count, iterations);
+    printf("std::sort:  %.2f ms\n", std_sort_ms / iterations);
+    printf("radix sort: %.2f ms (including key extraction)\n", radix_sort_ms / iterations);
+
+    delete[] depths;
+    delete[] keys;
+    delete[] indices;
+    delete[] sorted_depths;
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "../engine/skyline_packer.inl"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+using engine::SkylineNode;
+using engine::SkylinePacker;
+namespace skyline_packer = engine::skyline_packer;
+
+const int32_t page_size = 2048;
+
+struct Rect {
+    int32_t w, h;
+};
+
+// Packs every rect into as many pages as it takes, like AtlasBuilder, and reports pages, occupancy and time.
+void run(const char *label, const std::vector<Rect> &rects) {
+    using clock = std::chrono::high_resolution_clock;
+
+    std::vector<std::vector<SkylineNode>> nodes;
+    std::vector<SkylinePacker> pages;
+    uint64_t area = 0;
+
+    const auto start = clock::now();
+
+    for (const Rect &rect : rects) {
+        int32_t x = 0;
+        int32_t y = 0;
+        bool packed = false;
+
+        for (SkylinePacker &page : pages) {
+            if (skyline_packer::pack(page, rect.w, rect.h, x, y)) {
+                packed = true;
+                break;
+            }
+        }
+
+        if (!packed) {
+            nodes.emplace_back(skyline_packer::max_nodes(page_size));
+            pages.emplace_back();
+            skyline_packer::init(pages.back(), page_size, page_size, nodes.back().data(), (uint32_t)nodes.back().size());
+            skyline_packer::pack(pages.back(), rect.w, rect.h, x, y);
+        }
+
+        area += (uint64_t)rect.w * rect.h;
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    // Counts each page up to the bottom of its skyline, so a barely started last page doesn't drag the number down.
+    uint64_t page_area = 0;
+    for (const SkylinePacker &page : pages) {
+        int32_t bottom = 0;
+        for (uint32_t i = 0; i < page.node_count; ++i) {
+            bottom = std::max(bottom, page.nodes[i].y);
+        }
+        page_area += (uint64_t)page_size * bottom;
+    }
+
+    const double occupancy = (double)area / (double)page_area;
+
+    printf("%-18s %6zu  %5zu  %9.1f%%  %8.2f  %10.3f\n", label, rects.size(), pages.size(), occupancy * 100.0, ms, ms * 1000.0 / rects.size());
+}
+
+} // namespace
+
+// Measures packing thousands of random sprite sized rects into 2048x2048 pages, in arrival order and sorted by height.
+int main(int, char **) {
+    printf("order              rects   pages  occupancy  time (ms)  us per rect\n");
+
+    const uint32_t counts[] = {1000, 5000, 20000};
+    for (uint32_t count : counts) {
+        srand(1);
+
+        std::vector<Rect> rects(count);
+        for (Rect &rect : rects) {
+            rect = {8 + rand() % 57, 8 + rand() % 57};
+        }
+
+        run("arrival", rects);
+
+        std::sort(rects.begin(), rects.end(), [](const Rect &a, const Rect &b) {
+            return a.h > b.h || (a.h == b.h && a.w > b.w);
+        });
+
+        run("sorted by height", rects);
+    }
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "../engine/math.inl"
+#include "../engine/spatial_grid.h"
+#include <array.h>
+#include <chrono>
+#include <memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+const uint32_t sprite_count = 100000;
+const uint32_t query_count = 1000;
+const float world_size = 8192.0f;
+const float sprite_size = 32.0f;
+
+// The corners commit_sprites writes, in the sprite's own coordinates.
+const glm::vec2 unit_quad[4] = {{0.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}, {1.0f, 0.0f}};
+
+float random_float(float range) {
+    return (float)rand() / (float)RAND_MAX * range;
+}
+
+// The bounds Sprites stores in its grid.
+void sprite_bounds(const math::Transform2D &transform, glm::vec2 &min, glm::vec2 &max) {
+    min = max = transform.origin;
+
+    for (int i = 1; i < 4; ++i) {
+        const glm::vec2 corner = math::transform_point(transform, unit_quad[i]);
+        min = glm::min(min, corner);
+        max = glm::max(max, corner);
+    }
+}
+
+// Finding sprites without the grid: every sprite's quad transformed and tested against the rect.
+void scan_rect(const std::vector<math::Transform2D> &transforms, glm::vec2 min, glm::vec2 max, std::vector<uint64_t> &ids) {
+    for (uint32_t i = 0; i < transforms.size(); ++i) {
+        glm::vec2 sprite_min, sprite_max;
+        sprite_bounds(transforms[i], sprite_min, sprite_max);
+
+        if (sprite_min.x <= max.x && sprite_max.x >= min.x && sprite_min.y <= max.y && sprite_max.y >= min.y) {
+            ids.push_back(i + 1);
+        }
+    }
+}
+
+} // namespace
+
+// Measures building a SpatialGrid over 100k rotated sprites, moving a tenth of them, and point, rect and radius
+// queries against scanning every sprite.
+int main(int, char **) {
+    using namespace engine;
+    using namespace foundation;
+    using clock = std::chrono::high_resolution_clock;
+
+    memory_globals::init();
+
+    {
+        std::vector<math::Transform2D> transforms(sprite_count);
+        std::vector<glm::vec2> points(query_count);
+
+        srand(1);
+        for (uint32_t i = 0; i < sprite_count; ++i) {
+            const float angle = random_float(6.2831853f);
+            math::Transform2D &transform = transforms[i];
+            transform.x_axis = glm::vec2(cosf(angle), sinf(angle)) * sprite_size;
+            transform.y_axis = glm::vec2(-sinf(angle), cosf(angle)) * sprite_size;
+            transform.origin = {random_float(world_size), random_float(world_size)};
+            transform.z = 0.0f;
+        }
+
+        for (uint32_t i = 0; i < query_count; ++i) {
+            points[i] = {random_float(world_size), random_float(world_size)};
+        }
+
+        SpatialGrid grid(memory_globals::default_allocator());
+        Array<uint64_t> ids(memory_globals::default_allocator());
+        std::vector<uint64_t> scanned;
+
+        auto start = clock::now();
+        for (uint32_t i = 0; i < sprite_count; ++i) {
+            glm::vec2 min, max;
+            sprite_bounds(transforms[i], min, max);
+            spatial_grid::insert(grid, i + 1, min, max);
+        }
+        const double build_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        // A tenth of the sprites move a little, like a commit after an update.
+        start = clock::now();
+        for (uint32_t i = 0; i < sprite_count; i += 10) {
+            transforms[i].origin += glm::vec2(random_float(64.0f) - 32.0f, random_float(64.0f) - 32.0f);
+
+            glm::vec2 min, max;
+            sprite_bounds(transforms[i], min, max);
+            spatial_grid::insert(grid, i + 1, min, max);
+        }
+        const double move_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        printf("%u sprites, %u queries each\n", sprite_count, query_count);
+        printf("build %.2f ms, moving %u sprites %.2f ms\n\n", build_ms, sprite_count / 10, move_ms);
+        printf("query            grid (us)  scan (us)  average hits\n");
+
+        const glm::vec2 rect_extent = {512.0f, 288.0f};
+        const float radius = 128.0f;
+
+        size_t point_hits = 0;
+        start = clock::now();
+        for (uint32_t i = 0; i < query_count; ++i) {
+            array::clear(ids);
+            spatial_grid::query_point(grid, points[i], ids);
+            point_hits += array::size(ids);
+        }
+        const double point_us = std::chrono::duration<double, std::micro>(clock::now() - start).count() / query_count;
+
+        size_t rect_hits = 0;
+        start = clock::now();
+        for (uint32_t i = 0; i < query_count; ++i) {
+            array::clear(ids);
+            spatial_grid::query(grid, points[i], points[i] + rect_extent, ids);
+            rect_hits += array::size(ids);
+        }
+        const double rect_us = std::chrono::duration<double, std::micro>(clock::now() - start).count() / query_count;
+
+        size_t radius_hits = 0;
+        start = clock::now();
+        for (uint32_t i = 0; i < query_count; ++i) {
+            array::clear(ids);
+            spatial_grid::query_radius(grid, points[i], radius, ids);
+            radius_hits += array::size(ids);
+        }
+        const double radius_us = std::chrono::duration<double, std::micro>(clock::now() - start).count() / query_count;
+
+        // Scanning is the same work for every shape, measured with the rect.
+        size_t scan_hits = 0;
+        const uint32_t scan_count = query_count / 10;
+        start = clock::now();
+        for (uint32_t i = 0; i < scan_count; ++i) {
+            scanned.clear();
+            scan_rect(transforms, points[i], points[i] + rect_extent, scanned);
+            scan_hits += scanned.size();
+        }
+        const double scan_us = std::chrono::duration<double, std::micro>(clock::now() - start).count() / scan_count;
+
+        printf("point   %17.2f  %9.2f  %12.2f\n", point_us, scan_us, (double)point_hits / query_count);
+        printf("rect    %17.2f  %9.2f  %12.2f\n", rect_us, scan_us, (double)rect_hits / query_count);
+        printf("radius  %17.2f  %9.2f  %12.2f\n", radius_us, scan_us, (double)radius_hits / query_count);
+
+        volatile size_t sink = scan_hits;
+        (void)sink;
+    }
+
+    memory_globals::shutdown();
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "../engine/math.inl"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+using clock_type = std::chrono::high_resolution_clock;
+
+const uint32_t old_capacity = 1000000;
+const uint32_t default_capacity = 1024;
+const uint32_t regions = 3;
+const int iterations = 10;
+
+// The index buffer reserve_sprites builds, two triangles per sprite.
+uint32_t *make_indices(uint32_t capacity) {
+    uint32_t *index_data = (uint32_t *)malloc(sizeof(uint32_t) * 6 * (size_t)capacity);
+
+    for (uint32_t i = 0; i < capacity; ++i) {
+        index_data[i * 6 + 0] = i * 4 + 0;
+        index_data[i * 6 + 1] = i * 4 + 1;
+        index_data[i * 6 + 2] = i * 4 + 2;
+
+        index_data[i * 6 + 3] = i * 4 + 0;
+        index_data[i * 6 + 4] = i * 4 + 3;
+        index_data[i * 6 + 5] = i * 4 + 1;
+    }
+
+    return index_data;
+}
+
+// The CPU side of the old constructor: 1M sprites' indices, and every vertex of the mapped buffer initialized.
+double construct_fixed() {
+    const auto start = clock_type::now();
+
+    uint32_t *index_data = make_indices(old_capacity);
+    math::Vertex *vertex_data = (math::Vertex *)malloc(sizeof(math::Vertex) * 4 * (size_t)old_capacity);
+
+    for (uint32_t i = 0; i < old_capacity; ++i) {
+        vertex_data[i * 4 + 0].position = {0.0f, 0.0f, 0.0f};
+        vertex_data[i * 4 + 1].position = {1.0f, 1.0f, 0.0f};
+        vertex_data[i * 4 + 2].position = {0.0f, 1.0f, 0.0f};
+        vertex_data[i * 4 + 3].position = {1.0f, 0.0f, 0.0f};
+
+        for (int ii = 0; ii < 4; ++ii) {
+            vertex_data[i * 4 + ii].color = {1.0f, 1.0f, 1.0f, 1.0f};
+            vertex_data[i * 4 + ii].texture_coords = {0.0f, 0.0f};
+        }
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+
+    volatile float sink = vertex_data[rand() % old_capacity].position.x + (float)index_data[rand() % old_capacity];
+    (void)sink;
+
+    free(vertex_data);
+    free(index_data);
+    return ms;
+}
+
+// The CPU side of reserve_sprites, which leaves the vertices to the commits writing them.
+double reserve(uint32_t capacity) {
+    const auto start = clock_type::now();
+    uint32_t *index_data = make_indices(capacity);
+    const double ms = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+
+    volatile uint32_t sink = index_data[rand() % capacity];
+    (void)sink;
+
+    free(index_data);
+    return ms;
+}
+
+double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+// Compares the CPU work and memory of constructing Sprites with the old fixed 1M capacity against the default
+// capacity, and against growing from it to 1M by doubling. The GL buffer allocations aren't included.
+int main(int, char **) {
+    double fixed_ms = 0.0;
+    double default_ms = 0.0;
+    double grown_ms = 0.0;
+
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        fixed_ms += construct_fixed();
+        default_ms += reserve(default_capacity);
+
+        for (uint32_t capacity = default_capacity;; capacity = capacity * 2 < old_capacity ? capacity * 2 : old_capacity) {
+            grown_ms += reserve(capacity);
+            if (capacity == old_capacity) {
+                break;
+            }
+        }
+    }
+
+    const size_t fixed_bytes = sizeof(math::Vertex) * 4 * (size_t)old_capacity + sizeof(uint32_t) * 6 * (size_t)old_capacity;
+    const size_t default_bytes = sizeof(math::PackedVertex) * 4 * (size_t)default_capacity * regions + sizeof(uint32_t) * 6 * (size_t)default_capacity;
+
+    printf("average of %d runs\n", iterations);
+    printf("construction                  CPU (ms)  buffers (MB)\n");
+    printf("fixed %7u sprites         %8.3f  %12.1f\n", old_capacity, fixed_ms / iterations, megabytes(fixed_bytes));
+    printf("default %5u sprites         %8.3f  %12.3f\n", default_capacity, default_ms / iterations, megabytes(default_bytes));
+    printf("grown to %7u by doubling  %8.3f\n", old_capacity, grown_ms / iterations);
+
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "../engine/easing.inl"
+#include "../engine/util.inl"
+#include <array.h>
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <hash.h>
+#include <memory.h>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+using namespace engine;
+using namespace foundation;
+
+const uint32_t tween_count = 100000;
+const int frames = 60;
+const float frame_time = 1.0f / 60.0f;
+
+float random_float(float range) {
+    return (float)rand() / (float)RAND_MAX * range;
+}
+
+// The old animation, one ~180 byte struct per tween whatever its channel.
+struct OldAnimation {
+    uint64_t animation_id;
+    uint64_t sprite_id;
+    float start_time;
+    float duration;
+    bool completed;
+    glm::mat4 from_transform;
+    glm::mat4 to_transform;
+    glm::vec4 from_color;
+    glm::vec4 to_color;
+};
+
+// The old sprites, a transform per sprite and a mutex every transform_sprite call took.
+struct OldSprites {
+    OldSprites(Allocator &allocator)
+    : indices(allocator)
+    , transforms(allocator)
+    , animations(allocator)
+    , done_animations(allocator) {}
+
+    std::mutex mutex;
+    Hash<uint32_t> indices;
+    Array<glm::mat4> transforms;
+    Array<OldAnimation> animations;
+    Array<OldAnimation> done_animations;
+};
+
+// The position channel of the new store, only the fields an update reads, with completed tweens swap-removed.
+struct PositionTweens {
+    PositionTweens(Allocator &allocator)
+    : animation_ids(allocator)
+    , sprite_ids(allocator)
+    , start_times(allocator)
+    , durations(allocator)
+    , easings(allocator)
+    , from(allocator)
+    , to(allocator) {}
+
+    Array<uint64_t> animation_ids;
+    Array<uint64_t> sprite_ids;
+    Array<float> start_times;
+    Array<float> durations;
+    Array<Easing> easings;
+    Array<glm::vec3> from;
+    Array<glm::vec3> to;
+};
+
+// The new sprites, positions written while updating without taking a lock.
+struct NewSprites {
+    NewSprites(Allocator &allocator)
+    : indices(allocator)
+    , positions(allocator)
+    , tweens(allocator)
+    , done_animations(allocator) {}
+
+    Hash<uint32_t> indices;
+    Array<glm::vec3> positions;
+    PositionTweens tweens;
+    Array<uint64_t> done_animations;
+};
+
+// The old update_sprites position path, and the array rebuilt whenever a tween completes.
+void update_old(OldSprites &sprites, float t) {
+    bool dirty = false;
+
+    for (OldAnimation *animation = array::begin(sprites.animations); animation != array::end(sprites.animations); ++animation) {
+        if (t < animation->start_time) {
+            continue;
+        }
+
+        float a = (t - animation->start_time) / animation->duration;
+        if (a > 1.0f) {
+            a = 1.0f;
+            animation->completed = true;
+            dirty = true;
+        }
+
+        const glm::vec3 from_pos = animation->from_transform[3];
+        const glm::vec3 to_pos = animation->to_transform[3];
+        const glm::vec3 mixed_pos = glm::mix(from_pos, to_pos, a);
+
+        glm::mat4 delta(1.0f);
+        delta = glm::translate(delta, -from_pos);
+        delta = glm::translate(delta, mixed_pos);
+
+        const glm::mat4 mixed_transform = delta * animation->from_transform;
+
+        std::scoped_lock lock(sprites.mutex);
+        const uint32_t index = hash::get(sprites.indices, animation->sprite_id, UINT32_MAX);
+        if (index != UINT32_MAX) {
+            sprites.transforms[index] = mixed_transform;
+        }
+    }
+
+    if (dirty) {
+        Array<OldAnimation> animations(memory_globals::default_allocator());
+        array::reserve(animations, array::size(sprites.animations));
+
+        for (OldAnimation *animation = array::begin(sprites.animations); animation != array::end(sprites.animations); ++animation) {
+            if (animation->completed) {
+                array::push_back(sprites.done_animations, *animation);
+            } else {
+                array::push_back(animations, *animation);
+            }
+        }
+
+        sprites.animations = animations;
+    }
+}
+
+// The new update_tweens position path.
+void update_new(NewSprites &sprites, float t) {
+    PositionTweens &tweens = sprites.tweens;
+
+    uint32_t i = 0;
+    while (i < array::size(tweens.animation_ids)) {
+        const float start_time = tweens.start_times[i];
+        if (t < start_time) {
+            ++i;
+            continue;
+        }
+
+        const float duration = tweens.durations[i];
+        const float a = duration > 0.0f ? std::min((t - start_time) / duration, 1.0f) : 1.0f;
+        const glm::vec3 from = tweens.from[i];
+        const glm::vec3 to = tweens.to[i];
+
+        const uint32_t index = hash::get(sprites.indices, tweens.sprite_ids[i], UINT32_MAX);
+        if (index != UINT32_MAX) {
+            sprites.positions[index] = from + (to - from) * ease(tweens.easings[i], a);
+        }
+
+        if (a < 1.0f) {
+            ++i;
+            continue;
+        }
+
+        array::push_back(sprites.done_animations, tweens.animation_ids[i]);
+
+        swap_pop(tweens.animation_ids, i);
+        swap_pop(tweens.sprite_ids, i);
+        swap_pop(tweens.start_times, i);
+        swap_pop(tweens.durations, i);
+        swap_pop(tweens.easings, i);
+        swap_pop(tweens.from, i);
+        swap_pop(tweens.to, i);
+    }
+}
+
+} // namespace
+
+// Compares a second of frames updating 100k concurrent position tweens, a percent of them completing, in the old
+// AoS animations against the SoA tweens.
+int main(int, char **) {
+    using clock = std::chrono::high_resolution_clock;
+
+    memory_globals::init();
+
+    {
+        Allocator &allocator = memory_globals::default_allocator();
+        OldSprites old_sprites(allocator);
+        NewSprites new_sprites(allocator);
+
+        array::resize(old_sprites.transforms, tween_count);
+        array::resize(new_sprites.positions, tween_count);
+
+        // Durations spread over 1 to 100 seconds, so about a percent of the tweens completes during the second.
+        srand(1);
+        for (uint32_t i = 0; i < tween_count; ++i) {
+            const uint64_t sprite_id = i + 1;
+            const float duration = 1.0f + random_float(99.0f);
+            const glm::vec3 from = {random_float(8192.0f), random_float(8192.0f), 0.0f};
+            const glm::vec3 to = {random_float(8192.0f), random_float(8192.0f), 0.0f};
+
+            hash::set(old_sprites.indices, sprite_id, i);
+            hash::set(new_sprites.indices, sprite_id, i);
+
+            OldAnimation animation;
+            animation.animation_id = sprite_id;
+            animation.sprite_id = sprite_id;
+            animation.start_time = 0.0f;
+            animation.duration = duration;
+            animation.completed = false;
+            animation.from_transform = glm::translate(glm::mat4(1.0f), from);
+            animation.to_transform = glm::translate(glm::mat4(1.0f), to);
+            animation.from_color = glm::vec4(1.0f);
+            animation.to_color = glm::vec4(1.0f);
+            array::push_back(old_sprites.animations, animation);
+
+            PositionTweens &tweens = new_sprites.tweens;
+            array::push_back(tweens.animation_ids, sprite_id);
+            array::push_back(tweens.sprite_ids, sprite_id);
+            array::push_back(tweens.start_times, 0.0f);
+            array::push_back(tweens.durations, duration);
+            array::push_back(tweens.easings, Easing::EaseInOut);
+            array::push_back(tweens.from, from);
+            array::push_back(tweens.to, to);
+        }
+
+        auto start = clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            update_old(old_sprites, 1.0f + frame * frame_time);
+        }
+        const double old_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / frames;
+
+        start = clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            update_new(new_sprites, 1.0f + frame * frame_time);
+        }
+        const double new_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / frames;
+
+        printf("%u tweens, average of %d frames, %u completed\n", tween_count, frames, array::size(new_sprites.done_animations));
+        printf("layout  bytes per tween  frame (ms)\n");
+        printf("AoS     %15zu  %10.2f\n", sizeof(OldAnimation), old_ms);
+        printf("SoA     %15zu  %10.2f\n", sizeof(uint64_t) * 2 + sizeof(float) * 2 + sizeof(Easing) + sizeof(glm::vec3) * 2, new_ms);
+
+        volatile float sink = old_sprites.transforms[rand() % tween_count][3].x + new_sprites.positions[rand() % tween_count].x;
+        (void)sink;
+    }
+
+    memory_globals::shutdown();
+    return 0;
+}
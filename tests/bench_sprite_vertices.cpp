@@ -0,0 +1,108 @@
+#include "../engine/math.inl"
+#include "../engine/sprite_vertices.inl"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+const uint32_t sprite_count = 1000000;
+const int iterations = 10;
+
+// The sprite data commit_sprites reads, a transform, a frame's texture coords and a packed color.
+struct SpriteData {
+    math::Transform2D transform;
+    uint16_t texture_coords[4][2];
+    uint32_t color;
+};
+
+const glm::vec2 unit_quad[] = {
+    {0.0f, 0.0f},
+    {1.0f, 1.0f},
+    {0.0f, 1.0f},
+    {1.0f, 0.0f}};
+
+// The vertices commit_sprites wrote before, float colors and texture coords in a 36 byte math::Vertex.
+void write_vertices_unpacked(const SpriteData &sprite, math::Vertex *vertices) {
+    const glm::vec4 color = {
+        (float)(sprite.color & 0xff) / 255.0f,
+        (float)((sprite.color >> 8) & 0xff) / 255.0f,
+        (float)((sprite.color >> 16) & 0xff) / 255.0f,
+        (float)(sprite.color >> 24) / 255.0f};
+
+    for (int i = 0; i < 4; ++i) {
+        const glm::vec2 position = math::transform_point(sprite.transform, unit_quad[i]);
+        vertices[i].position = {position.x, position.y, sprite.transform.z};
+        vertices[i].color = color;
+        vertices[i].texture_coords = {sprite.texture_coords[i][0] / 65535.0f, sprite.texture_coords[i][1] / 65535.0f};
+    }
+}
+
+double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+// Compares writing the vertices of 1M sprites in the packed vertex format against the old unpacked one, and reports
+// the memory both take for a capacity of 1M sprites.
+int main(int, char **) {
+    using clock = std::chrono::high_resolution_clock;
+
+    std::vector<SpriteData> sprites(sprite_count);
+
+    srand(1);
+    for (SpriteData &sprite : sprites) {
+        const float angle = (float)(rand() % 628) / 100.0f;
+        const float scale = 16.0f + (float)(rand() % 64);
+        sprite.transform.x_axis = {cosf(angle) * scale, sinf(angle) * scale};
+        sprite.transform.y_axis = {-sinf(angle) * scale, cosf(angle) * scale};
+        sprite.transform.origin = {(float)(rand() % 100000), (float)(rand() % 100000)};
+        sprite.transform.z = (float)(rand() % 100);
+
+        for (int i = 0; i < 4; ++i) {
+            sprite.texture_coords[i][0] = (uint16_t)rand();
+            sprite.texture_coords[i][1] = (uint16_t)rand();
+        }
+
+        sprite.color = (uint32_t)rand() * 2654435761u;
+    }
+
+    std::vector<math::Vertex> unpacked((size_t)sprite_count * 4);
+    std::vector<math::PackedVertex> packed((size_t)sprite_count * 4);
+
+    double unpacked_ms = 0.0;
+    double packed_ms = 0.0;
+
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        auto start = clock::now();
+        for (uint32_t i = 0; i < sprite_count; ++i) {
+            write_vertices_unpacked(sprites[i], &unpacked[(size_t)i * 4]);
+        }
+        unpacked_ms += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        for (uint32_t i = 0; i < sprite_count; ++i) {
+            const SpriteData &sprite = sprites[i];
+            engine::write_sprite_vertices(&packed[(size_t)i * 4], sprite.transform, sprite.texture_coords, sprite.color);
+        }
+        packed_ms += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    }
+
+    // Commits write one region of the ring per frame, the buffer holds one per fence.
+    const uint32_t regions = 3;
+    const size_t index_bytes = sizeof(uint32_t) * 6 * (size_t)sprite_count;
+
+    printf("%u sprites, average of %d runs\n", sprite_count, iterations);
+    printf("format    vertex  commit (ms)  Msprites/s  vertex buffer (MB)\n");
+    printf("unpacked  %4zu B  %11.2f  %10.1f  %18.1f\n", sizeof(math::Vertex), unpacked_ms / iterations, sprite_count / (unpacked_ms / iterations) / 1000.0, megabytes(sizeof(math::Vertex) * 4 * (size_t)sprite_count));
+    printf("packed    %4zu B  %11.2f  %10.1f  %18.1f (x%u regions: %.1f)\n", sizeof(math::PackedVertex), packed_ms / iterations, sprite_count / (packed_ms / iterations) / 1000.0, megabytes(sizeof(math::PackedVertex) * 4 * (size_t)sprite_count), regions, megabytes(sizeof(math::PackedVertex) * 4 * (size_t)sprite_count * regions));
+    printf("index buffer %.1f MB\n", megabytes(index_bytes));
+
+    // Keep the writes from being optimized away.
+    volatile float sink = unpacked[rand() % unpacked.size()].position.x + packed[rand() % packed.size()].position.x;
+    (void)sink;
+
+    return 0;
+}
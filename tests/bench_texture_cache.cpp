@@ -0,0 +1,106 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "../engine/stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../engine/stb_image_write.h"
+
+#include "../engine/pixels.inl"
+#include "../engine/texture_cache.inl"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace {
+
+using clock_type = std::chrono::high_resolution_clock;
+
+const char *source_filename = "bench_texture_cache.png";
+const char *cache_filename = "bench_texture_cache.png.texcache";
+const uint64_t source_size = 1;
+const uint64_t source_modified = 2;
+
+double elapsed_ms(clock_type::time_point start) {
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+// What Texture does without a valid cache: decodes, expands to RGBA and writes the cache.
+double cold(std::vector<char> &file) {
+    const auto start = clock_type::now();
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    unsigned char *data = stbi_load(source_filename, &width, &height, &channels, 0);
+    if (!data) {
+        fprintf(stderr, "Couldn't decode: %s\n", stbi_failure_reason());
+        exit(1);
+    }
+
+    file.resize(sizeof(engine::TextureCacheHeader) + (size_t)width * height * 4);
+    engine::TextureCacheHeader header;
+    engine::texture_cache::init_header(header, (uint32_t)width, (uint32_t)height, source_size, source_modified);
+    memcpy(file.data(), &header, sizeof(header));
+    engine::pixels::to_rgba(data, channels, (uint8_t *)file.data() + sizeof(header), (size_t)width * height);
+    stbi_image_free(data);
+
+    FILE *out = fopen(cache_filename, "wb");
+    fwrite(file.data(), 1, file.size(), out);
+    fclose(out);
+
+    return elapsed_ms(start);
+}
+
+// What Texture does with a valid cache: one read and a header check, the pixels are ready to upload.
+double warm(std::vector<char> &file) {
+    const auto start = clock_type::now();
+
+    FILE *in = fopen(cache_filename, "rb");
+    fseek(in, 0, SEEK_END);
+    file.resize((size_t)ftell(in));
+    fseek(in, 0, SEEK_SET);
+    const size_t bytes_read = fread(file.data(), 1, file.size(), in);
+    fclose(in);
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (bytes_read != file.size() || !engine::texture_cache::pixels(file.data(), file.size(), source_size, source_modified, width, height)) {
+        fprintf(stderr, "Invalid cache\n");
+        exit(1);
+    }
+
+    return elapsed_ms(start);
+}
+
+} // namespace
+
+// Compares loading a large RGB sprite sheet by decoding the PNG against reading its texture cache, leaving out the GL
+// upload both share. The warm numbers are with the cache file in the OS file cache. Usage: bench_texture_cache [size]
+int main(int argc, char **argv) {
+    const int size = argc > 1 ? atoi(argv[1]) : 4096;
+
+    std::vector<unsigned char> image((size_t)size * size * 3);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            unsigned char *pixel = &image[((size_t)y * size + x) * 3];
+            pixel[0] = (unsigned char)((x / 16) * 37 + (y / 16) * 11);
+            pixel[1] = (unsigned char)((x / 16) * 5 + rand() % 4);
+            pixel[2] = (unsigned char)((y / 16) * 23);
+        }
+    }
+
+    stbi_write_png(source_filename, size, size, 3, image.data(), size * 3);
+
+    std::vector<char> file;
+    printf("%dx%d RGB  cold (ms)  warm (ms)\n", size, size);
+    for (int run = 0; run < 3; ++run) {
+        const double cold_ms = cold(file);
+        const double warm_ms = warm(file);
+        printf("run %d      %9.1f  %9.1f\n", run, cold_ms, warm_ms);
+    }
+
+    remove(source_filename);
+    remove(cache_filename);
+
+    return 0;
+}
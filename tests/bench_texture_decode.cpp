@@ -0,0 +1,156 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "../engine/stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../engine/stb_image_write.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint32_t max_strip_bytes = 4 * 1024 * 1024;
+
+// A texture as the TextureLoader sees it, decoded on a worker and consumed on the main thread.
+struct Decoded {
+    std::atomic<bool> done;
+    int width;
+    int height;
+    unsigned char *pixels;
+};
+
+// Writes a sprite sheet like image, flat colored blocks with some noise, so it compresses like real art.
+void write_texture(const char *filename, int size) {
+    std::vector<unsigned char> pixels((size_t)size * size * 4);
+    uint32_t seed = 0x9e3779b9u;
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            unsigned char *pixel = &pixels[((size_t)y * size + x) * 4];
+            const uint32_t block = (uint32_t)((x / 32) * 31 + (y / 32) * 17);
+            pixel[0] = (unsigned char)(block * 13 + (seed >> 29));
+            pixel[1] = (unsigned char)(block * 7);
+            pixel[2] = (unsigned char)(block * 3 + (seed >> 30));
+            pixel[3] = (x / 32 + y / 32) % 5 == 0 ? 0 : 255;
+        }
+    }
+
+    if (!stbi_write_png(filename, size, size, 4, pixels.data(), size * 4)) {
+        fprintf(stderr, "Couldn't write %s\n", filename);
+        exit(1);
+    }
+}
+
+// Decodes every texture on thread_count workers while the main thread stages the decoded ones in upload order, a
+// strip at a time like upload_textures does into its pixel buffer. Returns the milliseconds until all are staged.
+double run(const std::vector<std::string> &filenames, uint32_t thread_count) {
+    using clock = std::chrono::high_resolution_clock;
+
+    const auto start = clock::now();
+
+    std::vector<Decoded> decoded(filenames.size());
+    for (Decoded &texture : decoded) {
+        texture.done = false;
+    }
+
+    std::atomic<uint32_t> next = 0;
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        workers.emplace_back([&]() {
+            for (uint32_t index = next.fetch_add(1); index < filenames.size(); index = next.fetch_add(1)) {
+                int channels = 0;
+                Decoded &texture = decoded[index];
+                texture.pixels = stbi_load(filenames[index].c_str(), &texture.width, &texture.height, &channels, 4);
+                texture.done.store(true, std::memory_order_release);
+            }
+        });
+    }
+
+    std::vector<unsigned char> staging(max_strip_bytes);
+    for (Decoded &texture : decoded) {
+        while (!texture.done.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+
+        if (!texture.pixels) {
+            fprintf(stderr, "Couldn't decode: %s\n", stbi_failure_reason());
+            exit(1);
+        }
+
+        const size_t size = (size_t)texture.width * texture.height * 4;
+        for (size_t offset = 0; offset < size; offset += max_strip_bytes) {
+            memcpy(staging.data(), texture.pixels + offset, std::min((size_t)max_strip_bytes, size - offset));
+        }
+
+        stbi_image_free(texture.pixels);
+    }
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+}
+
+} // namespace
+
+// Measures loading 50 large textures with the TextureLoader's pipeline on 1 to N decode threads, without the GL upload
+// which needs a context. Usage: bench_texture_decode [texture_count] [texture_size]
+int main(int argc, char **argv) {
+    const uint32_t texture_count = argc > 1 ? (uint32_t)atoi(argv[1]) : 50;
+    const int texture_size = argc > 2 ? atoi(argv[2]) : 2048;
+    const uint32_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    printf("Writing %u %dx%d textures\n", texture_count, texture_size, texture_size);
+
+    std::vector<std::string> filenames;
+    for (uint32_t i = 0; i < texture_count; ++i) {
+        char filename[64];
+        snprintf(filename, sizeof(filename), "bench_texture_%02u.png", i);
+        filenames.push_back(filename);
+
+        // The same image under every name, the decoder doesn't know.
+        if (i == 0) {
+            write_texture(filename, texture_size);
+        } else {
+            FILE *source = fopen(filenames[0].c_str(), "rb");
+            FILE *copy = fopen(filename, "wb");
+            char buffer[65536];
+            size_t bytes = 0;
+            while ((bytes = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+                fwrite(buffer, 1, bytes, copy);
+            }
+            fclose(copy);
+            fclose(source);
+        }
+    }
+
+    printf("threads  total (ms)  speedup\n");
+
+    double single_ms = 0.0;
+    for (uint32_t thread_count = 1;; thread_count = std::min(thread_count * 2, max_threads)) {
+        const double ms = run(filenames, thread_count);
+        if (thread_count == 1) {
+            single_ms = ms;
+        }
+
+        printf("%7u  %10.1f  %7.2f\n", thread_count, ms, single_ms / ms);
+
+        if (thread_count == max_threads) {
+            break;
+        }
+    }
+
+    for (const std::string &filename : filenames) {
+        remove(filename.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <assert.h>
+#include <string.h>
+#include "../engine/atlas_json.inl"
+
+using engine::AtlasJsonFrame;
+using engine::AtlasJsonMeta;
+
+// The frames and meta of a parse.
+struct Parsed {
+    char image[64] = {};
+    glm::ivec2 size = {-1, -1};
+    char names[8][64] = {};
+    AtlasJsonFrame frames[8];
+    int frame_count = 0;
+    const char *error = nullptr;
+    uint32_t error_offset = 0;
+};
+
+bool parse(const char *json, Parsed &parsed) {
+    return engine::atlas_json::parse(
+        json, (uint32_t)strlen(json),
+        [&parsed](const AtlasJsonMeta &meta) {
+            memcpy(parsed.image, meta.image, meta.image_length);
+            parsed.size = meta.size;
+        },
+        [&parsed](const AtlasJsonFrame &frame) {
+            assert(parsed.frame_count < 8);
+            memcpy(parsed.names[parsed.frame_count], frame.name, frame.name_length);
+            parsed.frames[parsed.frame_count++] = frame;
+        },
+        parsed.error, parsed.error_offset);
+}
+
+void test_array() {
+    const char *json = R"({
+        "frames": [
+            {
+                "filename": "ship.png",
+                "frame": {"x": 1, "y": 2, "w": 30, "h": 40},
+                "rotated": false,
+                "trimmed": true,
+                "spriteSourceSize": {"x": 2, "y": 3, "w": 30, "h": 40},
+                "sourceSize": {"w": 34, "h": 46},
+                "pivot": {"x": 0.25, "y": -1.5e-1}
+            },
+            {"frame": {"h": 8, "w": 7, "y": 6, "x": 5}, "filename": "tile\"\u00e5\ud83d\ude00.png"}
+        ],
+        "meta": {"app": "https://www.codeandweb.com/texturepacker", "size": {"w": 64, "h": 64}, "scale": "1", "image": "atlas.png", "extra": [1, [2, {"a": null}], "]}"]}
+    })";
+
+    Parsed parsed;
+    assert(parse(json, parsed));
+    assert(strcmp(parsed.image, "atlas.png") == 0);
+    assert(parsed.size.x == 64 && parsed.size.y == 64);
+    assert(parsed.frame_count == 2);
+
+    assert(strcmp(parsed.names[0], "ship.png") == 0);
+    assert(parsed.frames[0].rect.origin.x == 1 && parsed.frames[0].rect.origin.y == 2);
+    assert(parsed.frames[0].rect.size.x == 30 && parsed.frames[0].rect.size.y == 40);
+    assert(parsed.frames[0].pivot.x == 0.25f && parsed.frames[0].pivot.y == -0.15f);
+    assert(!parsed.frames[0].rotated && parsed.frames[0].trimmed);
+    assert(parsed.frames[0].source_rect.origin.x == 2 && parsed.frames[0].source_rect.origin.y == 3);
+    assert(parsed.frames[0].source_rect.size.x == 30 && parsed.frames[0].source_rect.size.y == 40);
+    assert(parsed.frames[0].source_size.x == 34 && parsed.frames[0].source_size.y == 46);
+
+    // Escapes are decoded to UTF-8, the pivot defaults to the center.
+    assert(strcmp(parsed.names[1], "tile\"\xc3\xa5\xf0\x9f\x98\x80.png") == 0);
+    assert(parsed.frames[1].rect.origin.x == 5 && parsed.frames[1].rect.origin.y == 6);
+    assert(parsed.frames[1].rect.size.x == 7 && parsed.frames[1].rect.size.y == 8);
+    assert(parsed.frames[1].pivot.x == 0.5f && parsed.frames[1].pivot.y == 0.5f);
+
+    // Untrimmed sprites fill their source image.
+    assert(!parsed.frames[1].rotated && !parsed.frames[1].trimmed);
+    assert(parsed.frames[1].source_rect.origin.x == 0 && parsed.frames[1].source_rect.origin.y == 0);
+    assert(parsed.frames[1].source_rect.size.x == 7 && parsed.frames[1].source_rect.size.y == 8);
+    assert(parsed.frames[1].source_size.x == 7 && parsed.frames[1].source_size.y == 8);
+}
+
+void test_hash() {
+    const char *json = R"({"meta": {"image": "atlas.png"}, "frames": {"a.png": {"frame": {"x": 0, "y": 0, "w": 1, "h": 2}}, "b.png": {"frame": {"x": 3, "y": 4, "w": 5, "h": 6}, "rotated": true}}})";
+
+    Parsed parsed;
+    assert(parse(json, parsed));
+    assert(parsed.frame_count == 2);
+    assert(strcmp(parsed.names[0], "a.png") == 0);
+    assert(strcmp(parsed.names[1], "b.png") == 0);
+    assert(parsed.frames[1].rect.size.y == 6);
+    assert(!parsed.frames[0].rotated && parsed.frames[1].rotated);
+
+    // No size in the meta.
+    assert(parsed.size.x == 0 && parsed.size.y == 0);
+}
+
+void test_errors() {
+    const char *missing_h = R"({"frames": [{"filename": "a", "frame": {"x": 0, "y": 0, "w": 1}}], "meta": {"image": "a.png"}})";
+    const char *missing_image = R"({"frames": [], "meta": {}})";
+    const char *missing_frames = R"({"meta": {"image": "a.png"}})";
+    const char *truncated = R"({"frames": [{"filename": "a", "fra)";
+    const char *trailing = R"({"frames": [], "meta": {"image": "a.png"}} x)";
+
+    Parsed parsed;
+    assert(!parse(missing_h, parsed));
+    assert(strcmp(parsed.error, "frame missing \"h\"") == 0);
+
+    parsed = Parsed();
+    assert(!parse(missing_image, parsed));
+    assert(strcmp(parsed.error, "meta missing \"image\"") == 0);
+
+    parsed = Parsed();
+    assert(!parse(missing_frames, parsed));
+
+    parsed = Parsed();
+    assert(!parse(truncated, parsed));
+    assert(parsed.error_offset <= strlen(truncated));
+
+    parsed = Parsed();
+    assert(!parse(trailing, parsed));
+}
+
+void test_numbers() {
+    const char *numbers[] = {"0", "-12", "3.5", "1e3", "2.5E-2", "123456789012345678901234"};
+    const double values[] = {0.0, -12.0, 3.5, 1000.0, 0.025, 123456789012345678901234.0};
+
+    for (int i = 0; i < 6; ++i) {
+        engine::atlas_json::Parser p;
+        p.start = p.cursor = numbers[i];
+        p.end = numbers[i] + strlen(numbers[i]);
+
+        double value = 0.0;
+        assert(engine::atlas_json::parse_number(p, value));
+        assert(fabs(value - values[i]) <= fabs(values[i]) * 1e-15);
+        assert(p.cursor == p.end);
+    }
+}
+
+int main() {
+    test_array();
+    test_hash();
+    test_errors();
+    test_numbers();
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <assert.h>
+#include "../engine/fence_ring.inl"
+
+namespace {
+
+// Records fence traffic instead of talking to the GPU.
+struct MockFences {
+    uint32_t inserted = 0;
+    uint32_t waited = 0;
+    uint32_t removed = 0;
+    uintptr_t next_fence = 1;
+    uintptr_t last_waited = 0;
+};
+
+void *mock_insert(void *user_data) {
+    MockFences *mock = (MockFences *)user_data;
+    ++mock->inserted;
+    return (void *)mock->next_fence++;
+}
+
+void mock_wait(void *user_data, void *fence) {
+    MockFences *mock = (MockFences *)user_data;
+    ++mock->waited;
+    mock->last_waited = (uintptr_t)fence;
+}
+
+void mock_remove(void *user_data, void *fence) {
+    (void)fence;
+    MockFences *mock = (MockFences *)user_data;
+    ++mock->removed;
+}
+
+engine::FenceRing make_ring(MockFences &mock, uint32_t region_count) {
+    engine::FenceRing ring;
+    ring.ops.insert = mock_insert;
+    ring.ops.wait = mock_wait;
+    ring.ops.remove = mock_remove;
+    ring.ops.user_data = &mock;
+    ring.region_count = region_count;
+    return ring;
+}
+
+} // namespace
+
+void test_regions_cycle() {
+    MockFences mock;
+    engine::FenceRing ring = make_ring(mock, 3);
+
+    assert(engine::fence_ring::acquire(ring) == 1);
+    assert(engine::fence_ring::acquire(ring) == 2);
+    assert(engine::fence_ring::acquire(ring) == 0);
+    assert(engine::fence_ring::acquire(ring) == 1);
+
+    // Nothing was fenced, so nothing was waited on.
+    assert(mock.waited == 0);
+}
+
+void test_waits_only_on_reused_region() {
+    MockFences mock;
+    engine::FenceRing ring = make_ring(mock, 3);
+
+    // Frame 1 writes and draws region 1, frame 2 region 2.
+    uint32_t region = engine::fence_ring::acquire(ring);
+    engine::fence_ring::fence(ring, region);
+    uintptr_t first_fence = mock.next_fence - 1;
+
+    region = engine::fence_ring::acquire(ring);
+    engine::fence_ring::fence(ring, region);
+    assert(mock.waited == 0);
+
+    // Frame 3 writes region 0 which was never drawn.
+    region = engine::fence_ring::acquire(ring);
+    assert(region == 0);
+    assert(mock.waited == 0);
+    engine::fence_ring::fence(ring, region);
+
+    // Frame 4 wraps around to region 1 and must wait for the first frame's fence.
+    region = engine::fence_ring::acquire(ring);
+    assert(region == 1);
+    assert(mock.waited == 1);
+    assert(mock.last_waited == first_fence);
+    assert(mock.removed == 1);
+    assert(ring.fences[1] == nullptr);
+}
+
+void test_refence_replaces_fence() {
+    MockFences mock;
+    engine::FenceRing ring = make_ring(mock, 2);
+
+    uint32_t region = engine::fence_ring::acquire(ring);
+    engine::fence_ring::fence(ring, region);
+    engine::fence_ring::fence(ring, region);
+
+    assert(mock.inserted == 2);
+    assert(mock.removed == 1);
+}
+
+void test_clear() {
+    MockFences mock;
+    engine::FenceRing ring = make_ring(mock, 3);
+
+    for (int i = 0; i < 3; ++i) {
+        engine::fence_ring::fence(ring, engine::fence_ring::acquire(ring));
+    }
+
+    engine::fence_ring::clear(ring);
+
+    assert(mock.waited == 3);
+    assert(mock.removed == 3);
+
+    for (uint32_t i = 0; i < engine::FenceRing::max_regions; ++i) {
+        assert(ring.fences[i] == nullptr);
+    }
+}
+
+int main(int, char **) {
+    test_regions_cycle();
+    test_waits_only_on_reused_region();
+    test_refence_replaces_fence();
+    test_clear();
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <assert.h>
+#include <math.h>
+#include "../engine/easing.inl"
+#include "../engine/keyframes.inl"
+
+using engine::ease;
+using engine::Easing;
+using engine::Keyframe;
+
+bool near(float a, float b) {
+    return fabsf(a - b) < 1e-3f;
+}
+
+void test_easing_endpoints() {
+    const Easing easings[] = {Easing::Linear, Easing::EaseIn, Easing::EaseOut, Easing::EaseInOut, Easing::Step};
+
+    for (Easing easing : easings) {
+        assert(near(ease(easing, 0.0f), 0.0f));
+        assert(near(ease(easing, 1.0f), 1.0f));
+    }
+
+    assert(ease(Easing::EaseIn, 0.5f) < 0.5f);
+    assert(ease(Easing::EaseOut, 0.5f) > 0.5f);
+    assert(near(ease(Easing::EaseInOut, 0.5f), 0.5f));
+    assert(ease(Easing::Step, 0.99f) == 0.0f);
+}
+
+void test_cubic_bezier() {
+    // A linear curve.
+    const engine::CubicBezier linear = engine::easing::cubic_bezier(0.25f, 0.25f, 0.75f, 0.75f);
+    for (float x = 0.0f; x <= 1.0f; x += 0.05f) {
+        assert(near(ease(Easing::CubicBezier, x, &linear), x));
+    }
+
+    // CSS ease-in-out is symmetric around the middle and monotonic.
+    const engine::CubicBezier ease_in_out = engine::easing::cubic_bezier(0.42f, 0.0f, 0.58f, 1.0f);
+    assert(near(ease(Easing::CubicBezier, 0.5f, &ease_in_out), 0.5f));
+    assert(near(ease(Easing::CubicBezier, 0.25f, &ease_in_out) + ease(Easing::CubicBezier, 0.75f, &ease_in_out), 1.0f));
+
+    float previous = 0.0f;
+    for (float x = 0.0f; x <= 1.0f; x += 0.01f) {
+        const float y = ease(Easing::CubicBezier, x, &ease_in_out);
+        assert(y >= previous - 1e-4f);
+        previous = y;
+    }
+
+    // Without a curve it eases linearly.
+    assert(near(ease(Easing::CubicBezier, 0.3f), 0.3f));
+}
+
+void test_evaluate() {
+    Keyframe<float> keys[3];
+    keys[0].time = 0.0f;
+    keys[0].value = 0.0f;
+    keys[1].time = 1.0f;
+    keys[1].value = 10.0f;
+    keys[1].easing = Easing::Step;
+    keys[2].time = 3.0f;
+    keys[2].value = 20.0f;
+
+    uint32_t cursor = 0;
+
+    // Holds the ends outside the track.
+    assert(engine::keyframes::evaluate(keys, 3, -1.0f, cursor) == 0.0f);
+    assert(engine::keyframes::evaluate(keys, 3, 5.0f, cursor) == 20.0f);
+
+    cursor = 0;
+    assert(near(engine::keyframes::evaluate(keys, 3, 0.5f, cursor), 5.0f));
+    assert(cursor == 0);
+
+    // The second segment steps.
+    assert(engine::keyframes::evaluate(keys, 3, 2.0f, cursor) == 10.0f);
+    assert(cursor == 1);
+
+    // Going back searches.
+    assert(near(engine::keyframes::evaluate(keys, 3, 0.25f, cursor), 2.5f));
+    assert(cursor == 0);
+
+    assert(engine::keyframes::duration(keys, 3) == 3.0f);
+}
+
+void test_find_segment() {
+    Keyframe<float> keys[8];
+    for (int i = 0; i < 8; ++i) {
+        keys[i].time = (float)i;
+    }
+
+    // Jumps far from the cursor in both directions.
+    uint32_t cursor = 0;
+    assert(engine::keyframes::find_segment(keys, 8, 6.5f, cursor) == 6);
+    assert(engine::keyframes::find_segment(keys, 8, 1.5f, cursor) == 1);
+    assert(engine::keyframes::find_segment(keys, 8, 2.0f, cursor) == 2);
+    assert(engine::keyframes::find_segment(keys, 8, 7.0f, cursor) == 6);
+}
+
+int main() {
+    test_easing_endpoints();
+    test_cubic_bezier();
+    test_evaluate();
+    test_find_segment();
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <assert.h>
+#include "../engine/mipmap.inl"
+#include <stdlib.h>
+#include <vector>
+
+using namespace engine::mipmap;
+
+void test_level_size() {
+    assert(level_size(256, 0) == 256);
+    assert(level_size(256, 3) == 32);
+    assert(level_size(5, 1) == 2);
+    assert(level_size(5, 4) == 1);
+}
+
+void test_max_level() {
+    // Down to 1x1 when not an atlas.
+    assert(max_level(256, 256, -1) == 8);
+    assert(max_level(256, 64, -1) == 8);
+    assert(max_level(1, 1, -1) == 0);
+
+    // An atlas stops where texels get wider than the padding.
+    assert(max_level(256, 256, 0) == 0);
+    assert(max_level(256, 256, 1) == 0);
+    assert(max_level(256, 256, 2) == 1);
+    assert(max_level(256, 256, 7) == 2);
+    assert(max_level(256, 256, 8) == 3);
+    assert(max_level(4, 4, 64) == 2);
+}
+
+void test_downsample(int32_t width, int32_t height) {
+    std::vector<uint8_t> source((size_t)width * height * 4);
+    for (uint8_t &byte : source) {
+        byte = (uint8_t)rand();
+    }
+
+    const int32_t destination_width = level_size(width, 1);
+    const int32_t destination_height = level_size(height, 1);
+    std::vector<uint8_t> destination((size_t)destination_width * destination_height * 4);
+    downsample(source.data(), width, height, destination.data());
+
+    for (int32_t y = 0; y < destination_height; ++y) {
+        for (int32_t x = 0; x < destination_width; ++x) {
+            const int32_t x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+            const int32_t y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+
+            for (int32_t channel = 0; channel < 4; ++channel) {
+                const uint32_t sum = source[((size_t)y * 2 * width + x * 2) * 4 + channel]
+                                     + source[((size_t)y * 2 * width + x1) * 4 + channel]
+                                     + source[((size_t)y1 * width + x * 2) * 4 + channel]
+                                     + source[((size_t)y1 * width + x1) * 4 + channel];
+                assert(destination[((size_t)y * destination_width + x) * 4 + channel] == (sum + 2) / 4);
+            }
+        }
+    }
+}
+
+int main() {
+    srand(1);
+
+    test_level_size();
+    test_max_level();
+
+    // Widths around the 4 texel vector width, odd and single sizes.
+    for (int32_t width = 1; width <= 20; ++width) {
+        for (int32_t height = 1; height <= 5; ++height) {
+            test_downsample(width, height);
+        }
+    }
+
+    test_downsample(1024, 512);
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <assert.h>
+#include "../engine/mpsc_queue.inl"
+#include <thread>
+#include <vector>
+
+using engine::MPSCQueue;
+
+void test_fifo() {
+    MPSCQueue<uint32_t, 4> queue;
+    uint32_t value = 0;
+
+    assert(!engine::mpsc_queue::try_pop(queue, value));
+
+    // Wraps around a few laps.
+    for (uint32_t lap = 0; lap < 3; ++lap) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            assert(engine::mpsc_queue::try_push(queue, lap * 4 + i));
+        }
+
+        // Full.
+        assert(!engine::mpsc_queue::try_push(queue, 99u));
+
+        for (uint32_t i = 0; i < 4; ++i) {
+            assert(engine::mpsc_queue::try_pop(queue, value));
+            assert(value == lap * 4 + i);
+        }
+
+        assert(!engine::mpsc_queue::try_pop(queue, value));
+    }
+}
+
+void test_producers() {
+    const uint32_t producer_count = 4;
+    const uint32_t per_producer = 100000;
+
+    MPSCQueue<uint64_t, 1024> *queue = new MPSCQueue<uint64_t, 1024>();
+    std::vector<std::thread> producers;
+
+    for (uint32_t producer = 0; producer < producer_count; ++producer) {
+        producers.emplace_back([queue, producer]() {
+            for (uint32_t i = 0; i < per_producer; ++i) {
+                engine::mpsc_queue::push(*queue, ((uint64_t)producer << 32) | i);
+            }
+        });
+    }
+
+    // Every value arrives once, and each producer's values arrive in the order pushed.
+    uint32_t next[producer_count] = {};
+    uint32_t received = 0;
+    uint64_t value = 0;
+
+    while (received < producer_count * per_producer) {
+        if (!engine::mpsc_queue::try_pop(*queue, value)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const uint32_t producer = (uint32_t)(value >> 32);
+        assert(producer < producer_count);
+        assert((uint32_t)value == next[producer]);
+        ++next[producer];
+        ++received;
+    }
+
+    for (std::thread &thread : producers) {
+        thread.join();
+    }
+
+    assert(!engine::mpsc_queue::try_pop(*queue, value));
+
+    delete queue;
+}
+
+int main() {
+    test_fifo();
+    test_producers();
+    return 0;
+}
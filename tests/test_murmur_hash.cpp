@@ -0,0 +1,29 @@
+#include <assert.h>
+#include "../engine/murmur_hash.inl"
+
+using engine::hash_name;
+
+// Hashed at compile time.
+static_assert(hash_name("player_idle") == 0x950e922dc994f38aULL, "hash_name must be constexpr");
+
+void test_reference_keys() {
+    // Keys from foundation's murmur_hash_64 with seed 0, covering tails of every length and whole blocks.
+    assert(hash_name("") == 0x0000000000000000ULL);
+    assert(hash_name("a") == 0x071717d2d36b6b11ULL);
+    assert(hash_name("tile") == 0xe88029a32b2422a9ULL);
+    assert(hash_name("exactly8") == 0xbb7de483a10eb06eULL);
+    assert(hash_name("ship_big_blue_01.png") == 0xebfc3622e7b24de3ULL);
+    assert(hash_name("\xff\xfe\x80 high bytes") == 0xf0842a0c8561be6fULL);
+}
+
+void test_length() {
+    const char *name = "ship_big_blue_01.png";
+    assert(engine::murmur_hash::length(name) == 20);
+    assert(engine::murmur_hash::hash_64(name, 4, 0) == hash_name("ship"));
+}
+
+int main() {
+    test_reference_keys();
+    test_length();
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <assert.h>
+#include "../engine/pixels.inl"
+#include <stdlib.h>
+
+using engine::pixels::to_rgba;
+
+// The expected RGBA of a pixel of any channel count.
+void expected_rgba(const uint8_t *pixel, int channels, uint8_t rgba[4]) {
+    const bool color = channels >= 3;
+    const bool has_alpha = channels == 2 || channels == 4;
+    rgba[0] = pixel[0];
+    rgba[1] = color ? pixel[1] : pixel[0];
+    rgba[2] = color ? pixel[2] : pixel[0];
+    rgba[3] = has_alpha ? pixel[channels - 1] : 255;
+}
+
+void test_conversion(int channels, size_t count) {
+    // Exactly sized, so reading past the source shows up under a sanitizer. The guard catches writes past the end.
+    uint8_t *source = new uint8_t[count * channels + 1];
+    uint8_t *rgba = new uint8_t[count * 4 + 16];
+
+    for (size_t i = 0; i < count * channels; ++i) {
+        source[i] = (uint8_t)rand();
+    }
+
+    memset(rgba, 0xcd, count * 4 + 16);
+
+    assert(to_rgba(source, channels, rgba, count));
+
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t expected[4];
+        expected_rgba(&source[i * channels], channels, expected);
+        assert(memcmp(&rgba[i * 4], expected, 4) == 0);
+    }
+
+    for (size_t i = count * 4; i < count * 4 + 16; ++i) {
+        assert(rgba[i] == 0xcd);
+    }
+
+    delete[] rgba;
+    delete[] source;
+}
+
+int main() {
+    srand(1);
+
+    // Every tail length around the vector widths, and a row of a large sheet.
+    for (int channels = 1; channels <= 4; ++channels) {
+        for (size_t count = 0; count < 80; ++count) {
+            test_conversion(channels, count);
+        }
+
+        test_conversion(channels, 4099);
+    }
+
+    uint8_t pixel[4] = {};
+    assert(!to_rgba(pixel, 5, pixel, 1));
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <assert.h>
+#include "../engine/radix_sort.inl"
+#include <stdlib.h>
+
+using engine::radix_sort::float_key;
+
+void test_float_key_order() {
+    const float values[] = {-1000.0f, -1.5f, -0.0f, 0.0f, 0.25f, 1.0f, 99.0f, 1.0e9f};
+    const uint32_t count = sizeof(values) / sizeof(values[0]);
+
+    for (uint32_t i = 1; i < count; ++i) {
+        assert(float_key(values[i - 1]) <= float_key(values[i]));
+    }
+
+    assert(float_key(-2.0f) < float_key(-1.0f));
+    assert(float_key(-1.0f) < float_key(1.0f));
+}
+
+void test_sort_order() {
+    const uint32_t count = 10000;
+    float *depths = new float[count];
+    uint32_t *keys = new uint32_t[count * 2];
+    uint32_t *indices = new uint32_t[count * 2];
+
+    srand(1);
+    for (uint32_t i = 0; i < count; ++i) {
+        depths[i] = (float)(rand() % 2000 - 1000) / 10.0f;
+        keys[i] = float_key(depths[i]);
+        indices[i] = i;
+    }
+
+    engine::radix_sort::sort(keys, indices, keys + count, indices + count, count);
+
+    for (uint32_t i = 1; i < count; ++i) {
+        assert(depths[indices[i - 1]] <= depths[indices[i]]);
+        assert(keys[i] == float_key(depths[indices[i]]));
+    }
+
+    delete[] depths;
+    delete[] keys;
+    delete[] indices;
+}
+
+void test_sort_stability() {
+    // Only three distinct depths, so most keys tie and must keep their original order.
+    const uint32_t count = 3000;
+    uint32_t keys[count * 2];
+    uint32_t indices[count * 2];
+
+    for (uint32_t i = 0; i < count; ++i) {
+        keys[i] = float_key((float)(i % 3) - 1.0f);
+        indices[i] = i;
+    }
+
+    engine::radix_sort::sort(keys, indices, keys + count, indices + count, count);
+
+    for (uint32_t i = 1; i < count; ++i) {
+        if (keys[i - 1] == keys[i]) {
+            assert(indices[i - 1] < indices[i]);
+        } else {
+            assert(keys[i - 1] < keys[i]);
+        }
+    }
+}
+
+void test_sort_wide_keys() {
+    const uint32_t count = 5;
+    uint64_t keys[count * 2] = {0x0100000000000002ull, 0x0000000100000000ull, 0x0100000000000001ull, 0x0000000000000003ull, 0x0000000100000000ull};
+    uint32_t indices[count * 2] = {0, 1, 2, 3, 4};
+
+    engine::radix_sort::sort(keys, indices, keys + count, indices + count, count);
+
+    assert(indices[0] == 3);
+    assert(indices[1] == 1);
+    assert(indices[2] == 4);
+    assert(indices[3] == 2);
+    assert(indices[4] == 0);
+}
+
+void test_sort_equal_keys() {
+    const uint32_t count = 4;
+    uint32_t keys[count * 2] = {7, 7, 7, 7};
+    uint32_t indices[count * 2] = {0, 1, 2, 3};
+
+    engine::radix_sort::sort(keys, indices, keys + count, indices + count, count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        assert(indices[i] == i);
+    }
+}
+
+int main(int, char **) {
+    test_float_key_order();
+    test_sort_order();
+    test_sort_stability();
+    test_sort_wide_keys();
+    test_sort_equal_keys();
+
+    return 0;
+}
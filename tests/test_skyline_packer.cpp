@@ -0,0 +1,91 @@
+#include <assert.h>
+#include "../engine/skyline_packer.inl"
+#include <stdlib.h>
+#include <vector>
+
+using engine::SkylineNode;
+using engine::SkylinePacker;
+namespace skyline_packer = engine::skyline_packer;
+
+struct Packed {
+    int32_t x, y, w, h;
+};
+
+bool overlap(const Packed &a, const Packed &b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+void test_exact_fit() {
+    SkylineNode nodes[skyline_packer::max_nodes(64)];
+    SkylinePacker packer;
+    skyline_packer::init(packer, 64, 64, nodes, skyline_packer::max_nodes(64));
+
+    int32_t x = 0;
+    int32_t y = 0;
+    for (int i = 0; i < 4; ++i) {
+        assert(skyline_packer::pack(packer, 32, 32, x, y));
+        assert(x % 32 == 0 && y % 32 == 0);
+    }
+
+    assert(packer.node_count == 1);
+    assert(skyline_packer::occupancy(packer) == 1.0);
+    assert(!skyline_packer::pack(packer, 1, 1, x, y));
+}
+
+void test_too_large() {
+    SkylineNode nodes[skyline_packer::max_nodes(16)];
+    SkylinePacker packer;
+    skyline_packer::init(packer, 16, 16, nodes, skyline_packer::max_nodes(16));
+
+    int32_t x = 0;
+    int32_t y = 0;
+    assert(!skyline_packer::pack(packer, 17, 1, x, y));
+    assert(!skyline_packer::pack(packer, 1, 17, x, y));
+    assert(!skyline_packer::pack(packer, 0, 1, x, y));
+    assert(skyline_packer::pack(packer, 16, 16, x, y));
+    assert(x == 0 && y == 0);
+}
+
+void test_random() {
+    const int32_t size = 512;
+    std::vector<SkylineNode> nodes(skyline_packer::max_nodes(size));
+    SkylinePacker packer;
+    skyline_packer::init(packer, size, size, nodes.data(), (uint32_t)nodes.size());
+
+    std::vector<Packed> packed;
+    uint64_t area = 0;
+    srand(1);
+
+    for (int i = 0; i < 2000; ++i) {
+        Packed rect = {0, 0, 1 + rand() % 40, 1 + rand() % 40};
+        if (!skyline_packer::pack(packer, rect.w, rect.h, rect.x, rect.y)) {
+            continue;
+        }
+
+        assert(rect.x >= 0 && rect.y >= 0 && rect.x + rect.w <= size && rect.y + rect.h <= size);
+        for (const Packed &other : packed) {
+            assert(!overlap(rect, other));
+        }
+
+        packed.push_back(rect);
+        area += (uint64_t)rect.w * rect.h;
+    }
+
+    // The skyline stays sorted, contiguous and spans the page.
+    int32_t x = 0;
+    for (uint32_t i = 0; i < packer.node_count; ++i) {
+        assert(packer.nodes[i].x == x && packer.nodes[i].width > 0);
+        x += packer.nodes[i].width;
+    }
+    assert(x == size);
+
+    assert(packer.used_area == area);
+    assert(skyline_packer::occupancy(packer) > 0.5);
+}
+
+int main() {
+    test_exact_fit();
+    test_too_large();
+    test_random();
+    return 0;
+}
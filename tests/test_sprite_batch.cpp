@@ -0,0 +1,99 @@
+#include <assert.h>
+#include "../engine/radix_sort.inl"
+#include "../engine/sprite_batch.inl"
+
+using engine::batch_sprites;
+using engine::sprite_sort_key;
+using engine::SpriteBatch;
+
+// Sorts the keys and returns the number of draw calls.
+uint32_t draw_calls(uint64_t *keys, uint32_t count) {
+    uint64_t temp_keys[64];
+    uint32_t indices[64];
+    uint32_t temp_indices[64];
+    SpriteBatch batches[64];
+
+    assert(count <= 64);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        indices[i] = i;
+    }
+
+    engine::radix_sort::sort(keys, indices, temp_keys, temp_indices, count);
+    return batch_sprites(keys, count, batches);
+}
+
+void test_key_order() {
+    // Layer dominates depth.
+    assert(sprite_sort_key(0, 10.0f, 0) < sprite_sort_key(1, -10.0f, 0));
+
+    // Depth dominates atlas.
+    assert(sprite_sort_key(0, -1.0f, 3) < sprite_sort_key(0, 1.0f, 0));
+
+    // Atlas groups equal depths.
+    assert(sprite_sort_key(0, 1.0f, 0) < sprite_sort_key(0, 1.0f, 1));
+
+    assert(engine::sprite_sort_key_atlas(sprite_sort_key(2, 5.0f, 7)) == 7);
+}
+
+void test_same_depth_groups_atlases() {
+    // Two atlases interleaved at one depth batch into one draw call each.
+    uint64_t keys[] = {
+        sprite_sort_key(0, 0.0f, 0),
+        sprite_sort_key(0, 0.0f, 1),
+        sprite_sort_key(0, 0.0f, 0),
+        sprite_sort_key(0, 0.0f, 1),
+    };
+
+    assert(draw_calls(keys, 4) == 2);
+}
+
+void test_depth_interleaving_splits_batches() {
+    // Atlases alternating in depth must keep draw order, so every sprite is its own draw call.
+    uint64_t keys[] = {
+        sprite_sort_key(0, 1.0f, 0),
+        sprite_sort_key(0, 2.0f, 1),
+        sprite_sort_key(0, 3.0f, 0),
+        sprite_sort_key(0, 4.0f, 1),
+    };
+
+    assert(draw_calls(keys, 4) == 4);
+}
+
+void test_layers() {
+    // Each layer is drawn in turn, and the atlases within each layer share depth.
+    uint64_t keys[] = {
+        sprite_sort_key(1, 0.0f, 0),
+        sprite_sort_key(0, 0.0f, 0),
+        sprite_sort_key(1, 0.0f, 0),
+        sprite_sort_key(0, 0.0f, 0),
+        sprite_sort_key(1, 0.0f, 1),
+    };
+
+    SpriteBatch batches[5];
+    uint64_t temp_keys[5];
+    uint32_t indices[5] = {0, 1, 2, 3, 4};
+    uint32_t temp_indices[5];
+
+    engine::radix_sort::sort(keys, indices, temp_keys, temp_indices, 5);
+    uint32_t batch_count = batch_sprites(keys, 5, batches);
+
+    assert(batch_count == 2);
+    assert(batches[0].atlas == 0 && batches[0].first == 0 && batches[0].count == 4);
+    assert(batches[1].atlas == 1 && batches[1].first == 4 && batches[1].count == 1);
+}
+
+void test_empty() {
+    SpriteBatch batches[1];
+    assert(batch_sprites(nullptr, 0, batches) == 0);
+}
+
+int main(int, char **) {
+    test_key_order();
+    test_same_depth_groups_atlases();
+    test_depth_interleaving_splits_batches();
+    test_layers();
+    test_empty();
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <assert.h>
+#include "../engine/sprite_commands.inl"
+#include <vector>
+
+using engine::SpriteCommand;
+using engine::SpriteCommands;
+
+namespace {
+
+// The parts of a sprite the commands and the animation pass change.
+struct SpriteState {
+    std::vector<float> transforms; // The origin x of each transform applied on the next commit, in order.
+    uint32_t color = 0;
+};
+
+SpriteCommand transform_command(float x) {
+    SpriteCommand command = {};
+    command.type = SpriteCommand::Type::Transform;
+    command.transform.origin = {x, 0.0f};
+    return command;
+}
+
+SpriteCommand color_command(uint32_t color) {
+    SpriteCommand command = {};
+    command.type = SpriteCommand::Type::Color;
+    command.color = color;
+    return command;
+}
+
+void queue(SpriteCommands &commands, const SpriteCommand &command) {
+    bool pushed = engine::mpsc_queue::try_push(commands.queue, command);
+    assert(pushed);
+    (void)pushed;
+}
+
+void apply(SpriteState &state, const SpriteCommand &command) {
+    if (command.type == SpriteCommand::Type::Transform) {
+        state.transforms.push_back(command.transform.origin.x);
+    } else if (command.type == SpriteCommand::Type::Color) {
+        state.color = command.color;
+    }
+}
+
+} // namespace
+
+void test_drain_order() {
+    SpriteCommands *commands = new SpriteCommands();
+    SpriteState state;
+
+    queue(*commands, transform_command(1.0f));
+    queue(*commands, transform_command(2.0f));
+    queue(*commands, transform_command(3.0f));
+
+    engine::sprite_commands::drain(*commands, [&state](const SpriteCommand &command) {
+        apply(state, command);
+    });
+
+    assert(state.transforms.size() == 3);
+    assert(state.transforms[0] == 1.0f && state.transforms[1] == 2.0f && state.transforms[2] == 3.0f);
+
+    delete commands;
+}
+
+void test_animations_apply_over_queued_changes() {
+    SpriteCommands *commands = new SpriteCommands();
+    SpriteState state;
+
+    // transform_sprite and color_sprite earlier in the frame.
+    queue(*commands, transform_command(1.0f));
+    queue(*commands, color_command(0xff0000ff));
+
+    // A running position tween and color tween.
+    engine::sprite_commands::update(
+        *commands,
+        [&state](const SpriteCommand &command) {
+            apply(state, command);
+        },
+        [&state]() {
+            state.transforms.push_back(10.0f);
+            state.color = 0x00ff00ff;
+        });
+
+    // The tween's pose composes after the queued transform, and the tween's color wins.
+    assert(state.transforms.size() == 2);
+    assert(state.transforms[0] == 1.0f);
+    assert(state.transforms[1] == 10.0f);
+    assert(state.color == 0x00ff00ff);
+
+    // Changes queued after the update apply on commit, over the animations.
+    queue(*commands, color_command(0x0000ffff));
+    engine::sprite_commands::drain(*commands, [&state](const SpriteCommand &command) {
+        apply(state, command);
+    });
+
+    assert(state.color == 0x0000ffff);
+
+    delete commands;
+}
+
+int main() {
+    test_drain_order();
+    test_animations_apply_over_queued_changes();
+    return 0;
+}
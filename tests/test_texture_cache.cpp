@@ -0,0 +1,68 @@
+#include <assert.h>
+#include "../engine/texture_cache.inl"
+#include <vector>
+
+using engine::TextureCacheHeader;
+using engine::texture_cache::pixels;
+
+// A cache file of a 3x2 image decoded from a 1234 byte source modified at 5678.
+std::vector<char> make_cache() {
+    std::vector<char> file(sizeof(TextureCacheHeader) + 3 * 2 * 4);
+
+    TextureCacheHeader header;
+    engine::texture_cache::init_header(header, 3, 2, 1234, 5678);
+    memcpy(file.data(), &header, sizeof(header));
+
+    for (size_t i = sizeof(header); i < file.size(); ++i) {
+        file[i] = (char)i;
+    }
+
+    return file;
+}
+
+void test_valid() {
+    const std::vector<char> file = make_cache();
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const uint8_t *data = pixels(file.data(), file.size(), 1234, 5678, width, height);
+    assert(data == (const uint8_t *)file.data() + sizeof(TextureCacheHeader));
+    assert(width == 3 && height == 2);
+}
+
+void test_stale() {
+    const std::vector<char> file = make_cache();
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    // The source changed.
+    assert(!pixels(file.data(), file.size(), 1235, 5678, width, height));
+    assert(!pixels(file.data(), file.size(), 1234, 5679, width, height));
+
+    // Truncated, or with extra data.
+    assert(!pixels(file.data(), file.size() - 1, 1234, 5678, width, height));
+    assert(!pixels(file.data(), sizeof(TextureCacheHeader) - 1, 1234, 5678, width, height));
+    std::vector<char> longer = file;
+    longer.push_back(0);
+    assert(!pixels(longer.data(), longer.size(), 1234, 5678, width, height));
+
+    // Another format or version.
+    std::vector<char> other = file;
+    other[0] = 'X';
+    assert(!pixels(other.data(), other.size(), 1234, 5678, width, height));
+
+    other = file;
+    TextureCacheHeader header;
+    memcpy(&header, other.data(), sizeof(header));
+    header.version += 1;
+    memcpy(other.data(), &header, sizeof(header));
+    assert(!pixels(other.data(), other.size(), 1234, 5678, width, height));
+
+    assert(width == 0 && height == 0);
+}
+
+int main() {
+    test_valid();
+    test_stale();
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "engine/atlas.h"
+#include "engine/log.h"
+
+#include <array.h>
+#include <memory.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Bakes a TexturePacker JSON atlas into the binary atlas format, which Atlas loads by mapping it in place.
+// Usage: bake_atlas <atlas.json> <baked atlas>
+int main(int argc, char **argv) {
+    using namespace foundation;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <atlas.json> <baked atlas>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *atlas_filename = argv[1];
+    const char *baked_filename = argv[2];
+
+    memory_globals::init();
+    int result = EXIT_SUCCESS;
+
+    {
+        Allocator &allocator = memory_globals::default_allocator();
+        Buffer baked(allocator);
+        engine::bake_atlas(allocator, atlas_filename, baked);
+
+        FILE *file = fopen(baked_filename, "wb");
+        if (!file) {
+            log_error("Could not open %s for writing", baked_filename);
+            result = EXIT_FAILURE;
+        } else {
+            if (fwrite(array::begin(baked), 1, array::size(baked), file) != array::size(baked)) {
+                log_error("Could not write %s", baked_filename);
+                result = EXIT_FAILURE;
+            } else {
+                log_info("Baked %s into %s, %u bytes", atlas_filename, baked_filename, array::size(baked));
+            }
+
+            fclose(file);
+        }
+    }
+
+    memory_globals::shutdown();
+    return result;
+}